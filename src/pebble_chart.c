@@ -1,21 +1,123 @@
 #include "pebble_chart.h"
 
 #define NOT_SET -777 // magic number to represent not value not set
+#define PERSIST_MAX_POINTS 512 // upper limit on points saved by chart_layer_persist_layout
+#define HISTORY_BLOCK_SIZE 104 // bytes of encoded samples per history block
+#define HISTORY_NUM_CODES 5 // sizes of values in the bit-packed history, each with its own prefix
+#define HISTOGRAM_BIN_WIDTH 4 // default width in pixels of histogram bins
+
+// fixed-size block of delta-of-delta encoded samples, bit-packed
+// the header allows skipping the block without decoding it
+typedef struct {
+  int32_t iFirstX;
+  int32_t iFirstY;
+  int32_t iLastX;
+  int32_t iMinY;
+  int32_t iMaxY;
+  uint16_t iNumSamples;
+  uint16_t iNumBits;
+  uint8_t aEncoded[HISTORY_BLOCK_SIZE];
+} ChartHistoryBlock;
+
+// fixed-capacity double-ended queue of indices
+// used for tracking sliding window minimums/maximums
+typedef struct {
+  unsigned int* pItems;
+  unsigned int iCapacity;
+  unsigned int iHead;
+  unsigned int iCount;
+} ChartDeque;
+
+// ring of history blocks, oldest block is evicted when full
+// blocks are identified by a sequence number, stored at (sequence % iCapacity)
+typedef struct {
+  ChartHistoryBlock* pBlocks;
+  unsigned int iCapacity;
+  unsigned int iNumBlocks;
+  unsigned int iFirstSeq;
+  unsigned int iNumSamples;
+  ChartDeque minDeque; // blocks with increasing iMinY
+  ChartDeque maxDeque; // blocks with decreasing iMaxY
+  int32_t iLastX;
+  int32_t iLastY;
+  int32_t iLastDX;
+} ChartHistory;
+
+// rolling statistics over the last iWindow values
+// values are identified by a sequence number, stored at (sequence % iWindow)
+typedef struct {
+  float* pValues;
+  unsigned int iWindow;
+  unsigned int iNumValues;
+  float fSum;
+  float fExpAverage;
+  ChartDeque minDeque; // values with increasing value
+  ChartDeque maxDeque; // values with decreasing value
+} ChartRolling;
+
+// decoding position within a history block
+typedef struct {
+  const ChartHistoryBlock* pBlock;
+  unsigned int iBitPos;
+  unsigned int iRemaining;
+  int32_t x;
+  int32_t y;
+  int32_t dx;
+} ChartHistoryCursor;
+
+// heler struct for sorting x-axis values
+typedef struct {
+  float x_value;
+  int index;
+} ChartSortHelper;
 
 typedef struct {
   // original data
   float* pXOrigData;
   float* pYOrigData;
   unsigned int iNumOrigPoints;
+  unsigned int iNumSeries;
+#if PEBBLE_CHART_ENABLE_BUDGET
+  float* pYMinOrigData; // for data aggregated into buckets, with pYMaxOrigData
+  float* pYMaxOrigData;
+  unsigned int* pBucketCounts; // points in each bucket
+  unsigned int iBucketCapacity;
+  float fBucketOrigin; // buckets span fBucketSpan of x each, from the first point
+  float fBucketSpan; // 0 until the buckets are first coarsened
+#endif
+#if PEBBLE_CHART_ENABLE_HISTORY
+  ChartHistory history;
+#endif
 
   // cached data
   int* pXData;
   int* pYData;
+#if PEBBLE_CHART_ENABLE_SERIES
+  int* pYBaseData;
+#endif
   unsigned int iNumPoints;
+#if PEBBLE_CHART_ENABLE_OVERLAYS
+  int* pAverageData;
+  int* pBandMinData;
+  int* pBandMaxData;
+#endif
   int iXAxisIntercept;
   int iYAxisIntercept;
   int iYTicks;
   int iBarWidth;
+  unsigned int iPointCapacity;
+  unsigned int iSampling;
+  unsigned int iNumSampled;
+  float fLayoutXMin;
+  float fLayoutXMax;
+  float fLayoutYMin;
+  float fLayoutYMax;
+  float fXScale;
+  float fYScale;
+  float fLayoutXSep;
+#if PEBBLE_CHART_ENABLE_CURSOR
+  ChartSortHelper* pSortOrder; // kept from the layout for cursor lookups
+#endif
 
   // other attributes
   ChartPlotType typePlot;
@@ -28,14 +130,56 @@ typedef struct {
   float fYMin;
   float fYMax;
   bool bShowFrame;
+#if PEBBLE_CHART_ENABLE_ANIMATION
   bool bAnimate;
   uint32_t iAnimationDuration;
+#endif
+  bool bAutoscale;
+  float fAutoscaleHeadroom;
+#if PEBBLE_CHART_ENABLE_OVERLAYS
+  ChartAverageType typeAverage;
+  bool bShowBand;
+#endif
+  GColor clrOverlay;
+#if PEBBLE_CHART_ENABLE_HISTOGRAM
+  unsigned int iHistogramBins;
+#endif
+#if PEBBLE_CHART_ENABLE_SERIES
+  GColor aSeriesColors[CHART_MAX_SERIES];
+  uint8_t iSeriesColorsSet;
+#endif
+#if PEBBLE_CHART_ENABLE_CURSOR
+  float fCursorX;
+#endif
+#if PEBBLE_CHART_ENABLE_BUDGET
+  size_t iMemoryBudget;
+  unsigned int iHeapPercent;
+#endif
 
   // state
+  float fAutoXMin;
+  float fAutoXMax;
+  float fAutoYMin;
+  float fAutoYMax;
+#if PEBBLE_CHART_ENABLE_OVERLAYS
+  ChartRolling rolling;
+#endif
   bool bLayoutDirty;
-  Animation* pAnimation;
-  AnimationImplementation* pAnimationImpl;
+#if PEBBLE_CHART_ENABLE_ANIMATION
+  Animation* pAnimation; // created on first use, unless driven by pAnimator
+  ChartAnimator* pAnimator;
+  ChartLayer* pNextAnimated; // next chart registered with pAnimator
+  uint32_t iAnimationStart; // in ms, when driven by pAnimator
+  bool bAnimating; // driven by pAnimator and not yet finished
+  bool bMorph;
+  int16_t* pMorphData; // target pixel y-values of the morph, followed by the offsets from the start
+  unsigned int iNumMorphPoints;
+  int32_t iMorphRemaining; // fraction of the offsets left, 16.16 fixed-point
+#endif
   unsigned int iPointsToDraw;
+#if PEBBLE_CHART_ENABLE_CURSOR
+  Layer* pCursorLayer;
+#endif
 } ChartLayerData;
 
 // function prototypes
@@ -43,9 +187,23 @@ static int closest_log10(float);
 static float exponential10(int);
 static void chart_layer_update_func(Layer*, GContext*);
 static void chart_layer_update_layout(ChartLayer* layer);
+static void chart_layer_free_overlay_cache(ChartLayerData*);
+static void chart_layer_free_layout_cache(ChartLayerData*);
+static void chart_layer_map_overlays(ChartLayerData*, const GRect, const unsigned int);
+static void chart_layer_push_overlays(ChartLayerData*, const float);
+#if PEBBLE_CHART_ENABLE_OVERLAYS
+static bool rolling_init(ChartRolling*, const unsigned int);
+static void rolling_free(ChartRolling*);
+#endif
+#if PEBBLE_CHART_ENABLE_ANIMATION
 static void animation_started(Animation*, void*);
 static void animation_stopped(Animation*, bool, void*);
 static void animation_update(Animation*, const uint32_t);
+static void chart_animator_remove(ChartLayer*);
+static void chart_layer_stop_animation(ChartLayerData*);
+static void chart_layer_start_morph(ChartLayerData*, const int*, const int*, const unsigned int);
+static bool chart_layer_morph_to(ChartLayerData*, const uint32_t);
+#endif
 
 // helper to extract ChartLayerData from ChartLayer
 static ChartLayerData* get_chart_data(ChartLayer* layer) {
@@ -69,9 +227,46 @@ ChartLayer* chart_layer_create(GRect frame) {
   data->pXOrigData = NULL;
   data->pYOrigData = NULL;
   data->iNumOrigPoints = 0;
+  data->iNumSeries = 1;
+#if PEBBLE_CHART_ENABLE_BUDGET
+  data->pYMinOrigData = NULL;
+  data->pYMaxOrigData = NULL;
+  data->pBucketCounts = NULL;
+  data->iBucketCapacity = 0;
+  data->fBucketOrigin = 0;
+  data->fBucketSpan = 0;
+#endif
+#if PEBBLE_CHART_ENABLE_HISTORY
+  data->history = (ChartHistory) { .pBlocks = NULL };
+#endif
   data->pXData = NULL;
   data->pYData = NULL;
+#if PEBBLE_CHART_ENABLE_SERIES
+  data->pYBaseData = NULL;
+#endif
   data->iNumPoints = 0;
+#if PEBBLE_CHART_ENABLE_OVERLAYS
+  data->pAverageData = NULL;
+  data->pBandMinData = NULL;
+  data->pBandMaxData = NULL;
+#endif
+  data->iXAxisIntercept = 0;
+  data->iYAxisIntercept = 0;
+  data->iYTicks = 0;
+  data->iBarWidth = 0;
+  data->iPointCapacity = 0;
+  data->iSampling = 0;
+  data->iNumSampled = 0;
+  data->fLayoutXMin = 0;
+  data->fLayoutXMax = 0;
+  data->fLayoutYMin = 0;
+  data->fLayoutYMax = 0;
+  data->fXScale = 0;
+  data->fYScale = 0;
+  data->fLayoutXSep = 0;
+#if PEBBLE_CHART_ENABLE_CURSOR
+  data->pSortOrder = NULL;
+#endif
   data->bLayoutDirty = false;
   data->typePlot = eLINE;
   data->clrPlot = GColorWhite;
@@ -83,25 +278,51 @@ ChartLayer* chart_layer_create(GRect frame) {
   data->fYMin = NOT_SET;
   data->fYMax = NOT_SET;
   data->bShowFrame = false;
+#if PEBBLE_CHART_ENABLE_ANIMATION
   data->bAnimate = true;
   data->iAnimationDuration = 1500;
-  data->pAnimation = animation_create();
-  data->pAnimationImpl = (struct AnimationImplementation*) malloc(sizeof(struct AnimationImplementation));
+#endif
+  data->bAutoscale = false;
+  data->fAutoscaleHeadroom = 0;
+  data->fAutoXMin = NOT_SET;
+  data->fAutoXMax = NOT_SET;
+  data->fAutoYMin = NOT_SET;
+  data->fAutoYMax = NOT_SET;
+#if PEBBLE_CHART_ENABLE_OVERLAYS
+  data->typeAverage = eNO_AVERAGE;
+  data->bShowBand = false;
+#endif
+  data->clrOverlay = GColorWhite;
+#if PEBBLE_CHART_ENABLE_HISTOGRAM
+  data->iHistogramBins = 0;
+#endif
+#if PEBBLE_CHART_ENABLE_SERIES
+  data->iSeriesColorsSet = 0;
+#endif
+#if PEBBLE_CHART_ENABLE_CURSOR
+  data->fCursorX = NOT_SET;
+  data->pCursorLayer = NULL;
+#endif
+#if PEBBLE_CHART_ENABLE_BUDGET
+  data->iMemoryBudget = 0;
+  data->iHeapPercent = 0;
+#endif
+#if PEBBLE_CHART_ENABLE_OVERLAYS
+  data->rolling = (ChartRolling) { .pValues = NULL };
+#endif
+#if PEBBLE_CHART_ENABLE_ANIMATION
+  data->pAnimation = NULL;
+  data->pAnimator = NULL;
+  data->pNextAnimated = NULL;
+  data->iAnimationStart = 0;
+  data->bAnimating = false;
+  data->bMorph = false;
+  data->pMorphData = NULL;
+  data->iNumMorphPoints = 0;
+  data->iMorphRemaining = 0;
+#endif
   data->iPointsToDraw = 0;
 
-  // extra animation setup
-  animation_set_curve(data->pAnimation, AnimationCurveLinear);
-  animation_set_handlers(data->pAnimation, 
-			 ((AnimationHandlers) {
-			   .started = (AnimationStartedHandler)animation_started,
-			     .stopped = (AnimationStoppedHandler)animation_stopped
-			     }), layer);
-
-  data->pAnimationImpl->setup = NULL;
-  data->pAnimationImpl->teardown = NULL;
-  data->pAnimationImpl->update = &animation_update;
-  animation_set_implementation(data->pAnimation, data->pAnimationImpl);
-
   // sets function to draw
   layer_set_update_proc(chart_layer_get_layer(layer), chart_layer_update_func);
 
@@ -115,10 +336,29 @@ void chart_layer_destroy(ChartLayer* layer) {
     ChartLayerData* pData = get_chart_data(layer);
     free(pData->pXOrigData);
     free(pData->pYOrigData);
-    free(pData->pXData);
-    free(pData->pYData);
-    animation_destroy(pData->pAnimation);
-    free(pData->pAnimationImpl);
+#if PEBBLE_CHART_ENABLE_BUDGET
+    free(pData->pYMinOrigData);
+    free(pData->pYMaxOrigData);
+    free(pData->pBucketCounts);
+#endif
+#if PEBBLE_CHART_ENABLE_HISTORY
+    free(pData->history.pBlocks);
+    free(pData->history.minDeque.pItems);
+    free(pData->history.maxDeque.pItems);
+#endif
+    chart_layer_free_layout_cache(pData);
+#if PEBBLE_CHART_ENABLE_OVERLAYS
+    rolling_free(&pData->rolling);
+#endif
+#if PEBBLE_CHART_ENABLE_ANIMATION
+    chart_animator_remove(layer);
+    if (pData->pAnimation)
+      animation_destroy(pData->pAnimation);
+#endif
+#if PEBBLE_CHART_ENABLE_CURSOR
+    if (pData->pCursorLayer)
+      layer_destroy(pData->pCursorLayer);
+#endif
 
     // destroy "root" Layer
     layer_destroy(chart_layer_get_layer(layer));
@@ -128,8 +368,26 @@ void chart_layer_destroy(ChartLayer* layer) {
 //////////////////////////////////////
 // set attributes
 
+// returns true for the plot types compiled into the library
+static bool is_plot_type_enabled(const ChartPlotType type) {
+  switch (type) {
+  case eLINE:
+    return true;
+  case eSCATTER:
+    return PEBBLE_CHART_ENABLE_SCATTER;
+  case eBAR:
+    return PEBBLE_CHART_ENABLE_BAR;
+  case eHISTOGRAM:
+    return PEBBLE_CHART_ENABLE_HISTOGRAM;
+  case eSTACKED_BAR:
+  case eGROUPED_BAR:
+    return PEBBLE_CHART_ENABLE_SERIES;
+  }
+  return false;
+}
+
 void chart_layer_set_plot_type(ChartLayer* layer, const ChartPlotType type) {
-  if (layer) {
+  if (layer && is_plot_type_enabled(type)) {
     ChartLayerData* pData = get_chart_data(layer);
     pData->typePlot = type;
     pData->bLayoutDirty = true;
@@ -249,6 +507,7 @@ void chart_layer_show_frame(ChartLayer* layer, bool bShow) {
   }
 }
 
+#if PEBBLE_CHART_ENABLE_ANIMATION
 void chart_layer_animate(ChartLayer* layer, bool bAnimate) {
   if (layer) {
     ChartLayerData* pData = get_chart_data(layer);
@@ -263,8 +522,296 @@ void chart_layer_set_animation_duration(ChartLayer* layer, const uint32_t ms) {
   }
 }
 
+void chart_layer_set_morph(ChartLayer* layer, bool bMorph) {
+  if (layer) {
+    ChartLayerData* pData = get_chart_data(layer);
+    pData->bMorph = bMorph;
+  }
+}
+#endif
+
+void chart_layer_set_autoscale(ChartLayer* layer, bool bAutoscale, float fHeadroom) {
+  if (layer) {
+    ChartLayerData* pData = get_chart_data(layer);
+    pData->bAutoscale = bAutoscale;
+    pData->fAutoscaleHeadroom = fHeadroom;
+    pData->fAutoXMin = NOT_SET;
+    pData->fAutoXMax = NOT_SET;
+    pData->fAutoYMin = NOT_SET;
+    pData->fAutoYMax = NOT_SET;
+    pData->bLayoutDirty = true;
+
+    layer_mark_dirty(chart_layer_get_layer(layer));
+  }
+}
+
+#if PEBBLE_CHART_ENABLE_OVERLAYS
+bool chart_layer_set_overlays(ChartLayer* layer, const ChartAverageType typeAverage, const bool bShowBand, const unsigned int iWindow) {
+  if (!layer)
+    return false;
+
+  ChartLayerData* pData = get_chart_data(layer);
+  rolling_free(&pData->rolling);
+  pData->typeAverage = typeAverage;
+  pData->bShowBand = bShowBand;
+  pData->bLayoutDirty = true;
+  layer_mark_dirty(chart_layer_get_layer(layer));
+
+  if (((typeAverage != eNO_AVERAGE) || bShowBand) && iWindow)
+    return rolling_init(&pData->rolling, iWindow);
+  return true;
+}
+#endif
+
+#if PEBBLE_CHART_ENABLE_HISTOGRAM
+void chart_layer_set_histogram_bins(ChartLayer* layer, const unsigned int iNumBins) {
+  if (layer) {
+    ChartLayerData* pData = get_chart_data(layer);
+    pData->iHistogramBins = iNumBins;
+    pData->bLayoutDirty = true;
+
+    layer_mark_dirty(chart_layer_get_layer(layer));
+  }
+}
+#endif
+
+#if PEBBLE_CHART_ENABLE_SERIES
+void chart_layer_set_series_color(ChartLayer* layer, const unsigned int iSeries, GColor color) {
+  if (layer && (iSeries < CHART_MAX_SERIES)) {
+    ChartLayerData* pData = get_chart_data(layer);
+    pData->aSeriesColors[iSeries] = color;
+    pData->iSeriesColorsSet |= (1 << iSeries);
+
+    layer_mark_dirty(chart_layer_get_layer(layer));
+  }
+}
+#endif
+
+#if PEBBLE_CHART_ENABLE_BUDGET
+void chart_layer_set_memory_budget(ChartLayer* layer, const size_t iBytes, const unsigned int iHeapPercent) {
+  if (layer) {
+    ChartLayerData* pData = get_chart_data(layer);
+    pData->iMemoryBudget = iBytes;
+    pData->iHeapPercent = (iHeapPercent > 100) ? 100 : iHeapPercent;
+  }
+}
+#endif
+
+void chart_layer_set_overlay_color(ChartLayer* layer, GColor color) {
+  if (layer) {
+    ChartLayerData* pData = get_chart_data(layer);
+    pData->clrOverlay = color;
+
+    layer_mark_dirty(chart_layer_get_layer(layer));
+  }
+}
+
 ////////////////////////////////////
 
+// frees the previous data and allocates space for iNumPoints new points
+// there are iNumSeries y-values per point,
+// x-values are only allocated if bWithX
+static bool chart_layer_reserve_data(ChartLayerData* pData, const unsigned int iNumPoints, const unsigned int iNumSeries, const bool bWithX) {
+  // clean up previous data
+  free(pData->pXOrigData);
+  free(pData->pYOrigData);
+#if PEBBLE_CHART_ENABLE_BUDGET
+  free(pData->pYMinOrigData);
+  free(pData->pYMaxOrigData);
+  free(pData->pBucketCounts);
+  pData->pYMinOrigData = NULL;
+  pData->pYMaxOrigData = NULL;
+  pData->pBucketCounts = NULL;
+#endif
+#if PEBBLE_CHART_ENABLE_HISTORY
+  free(pData->history.pBlocks);
+  free(pData->history.minDeque.pItems);
+  free(pData->history.maxDeque.pItems);
+  pData->history = (ChartHistory) { .pBlocks = NULL };
+#endif
+
+  pData->iNumOrigPoints = iNumPoints;
+  pData->iNumSeries = iNumSeries;
+  pData->pXOrigData = (bWithX && iNumPoints) ? (float*) malloc(iNumPoints * sizeof(float)) : NULL;
+  pData->pYOrigData = iNumPoints ? (float*) malloc(iNumPoints * iNumSeries * sizeof(float)) : NULL;
+  pData->bLayoutDirty = true;
+
+  if (iNumPoints && ((bWithX && !pData->pXOrigData) || !pData->pYOrigData)) {
+    free(pData->pXOrigData);
+    free(pData->pYOrigData);
+    pData->pXOrigData = NULL;
+    pData->pYOrigData = NULL;
+    pData->iNumOrigPoints = 0;
+    pData->iNumSeries = 1;
+    return false;
+  }
+  return true;
+}
+
+// returns true for the plot types drawn as bars
+static bool is_bar_plot(const ChartPlotType type) {
+  return (type == eBAR) || (type == eHISTOGRAM) || (type == eSTACKED_BAR) || (type == eGROUPED_BAR);
+}
+
+// copies values of the given type into pDest as floats
+static void copy_values(float* pDest, const void* pSrc, const ChartDataType type, const unsigned int iNumValues) {
+  if (type == eINT) {
+    // cast
+    for (unsigned int i = 0; i < iNumValues; ++i)
+      pDest[i] = (float)(((int*)pSrc)[i]);
+  }
+  else if (type == eFLOAT) {
+    memcpy(pDest, pSrc, iNumValues * sizeof(float));
+  }
+}
+
+#if PEBBLE_CHART_ENABLE_BUDGET || PEBBLE_CHART_ENABLE_SPARKLINE
+// reads the i-th value of the given type as a float
+static float read_value(const void* pSrc, const ChartDataType type, const unsigned int i) {
+  return (type == eINT) ? (float)(((const int*)pSrc)[i]) : ((const float*)pSrc)[i];
+}
+#endif
+
+#if PEBBLE_CHART_ENABLE_BUDGET
+// bytes which the data of the chart may take, the smaller of the
+// fixed budget and the share of the free heap
+static size_t chart_layer_data_budget(const ChartLayerData* pData) {
+  size_t iBudget = pData->iMemoryBudget ? pData->iMemoryBudget : SIZE_MAX;
+  if (pData->iHeapPercent) {
+    const size_t iHeapBudget = heap_bytes_free() / 100 * pData->iHeapPercent;
+    if (iHeapBudget < iBudget)
+      iBudget = iHeapBudget;
+  }
+  return iBudget;
+}
+
+// index of the bucket spanning x, kept as a float as it may exceed the int range
+static float chart_layer_bucket_index(const ChartLayerData* pData, const float x) {
+  const float fIndex = (x - pData->fBucketOrigin) / pData->fBucketSpan;
+  if (fIndex <= 0)
+    return 0;
+  return (fIndex < 8388608.0f) ? (float)(int)fIndex : fIndex;
+}
+
+// true if x falls into the last bucket
+// before the buckets are first coarsened, only points with the same x share a bucket
+static bool chart_layer_in_last_bucket(const ChartLayerData* pData, const float x) {
+  const float fLastX = pData->pXOrigData[pData->iNumOrigPoints - 1];
+  if (!pData->fBucketSpan)
+    return x <= fLastX;
+  return chart_layer_bucket_index(pData, x) <= chart_layer_bucket_index(pData, fLastX);
+}
+
+// merges bucket i into bucket j, weighting the means by their number of points
+static void chart_layer_merge_bucket(ChartLayerData* pData, const unsigned int j, const unsigned int i) {
+  const float fWeight = (float)pData->pBucketCounts[i] / (pData->pBucketCounts[j] + pData->pBucketCounts[i]);
+  pData->pXOrigData[j] += (pData->pXOrigData[i] - pData->pXOrigData[j]) * fWeight;
+  pData->pYOrigData[j] += (pData->pYOrigData[i] - pData->pYOrigData[j]) * fWeight;
+  if (pData->pYMinOrigData[i] < pData->pYMinOrigData[j])
+    pData->pYMinOrigData[j] = pData->pYMinOrigData[i];
+  if (pData->pYMaxOrigData[i] > pData->pYMaxOrigData[j])
+    pData->pYMaxOrigData[j] = pData->pYMaxOrigData[i];
+  pData->pBucketCounts[j] += pData->pBucketCounts[i];
+}
+
+// doubles the x-span of the buckets, merging the buckets which now share one
+// the first span fits the buckets so far into half of the capacity
+static void chart_layer_coarsen_buckets(ChartLayerData* pData) {
+  if (pData->fBucketSpan)
+    pData->fBucketSpan *= 2;
+  else {
+    pData->fBucketSpan = (pData->pXOrigData[pData->iNumOrigPoints - 1] - pData->fBucketOrigin) / (pData->iBucketCapacity / 2);
+    if (!(pData->fBucketSpan > 0))
+      pData->fBucketSpan = 1;
+  }
+
+  // a bucket's mean x lies within its span, so gives its index
+  unsigned int j = 0;
+  for (unsigned int i = 1; i < pData->iNumOrigPoints; ++i) {
+    if (chart_layer_bucket_index(pData, pData->pXOrigData[i]) <= chart_layer_bucket_index(pData, pData->pXOrigData[j]))
+      chart_layer_merge_bucket(pData, j, i);
+    else if (++j < i) {
+      pData->pXOrigData[j] = pData->pXOrigData[i];
+      pData->pYOrigData[j] = pData->pYOrigData[i];
+      pData->pYMinOrigData[j] = pData->pYMinOrigData[i];
+      pData->pYMaxOrigData[j] = pData->pYMaxOrigData[i];
+      pData->pBucketCounts[j] = pData->pBucketCounts[i];
+    }
+  }
+  pData->iNumOrigPoints = j + 1;
+}
+
+// adds a point to the bucket spanning its x-value, starting a new one if needed
+// the buckets are coarsened while there is no space for a new one
+static void chart_layer_push_bucket(ChartLayerData* pData, const float x, const float y) {
+  if (!pData->iNumOrigPoints)
+    pData->fBucketOrigin = x;
+  while ((pData->iNumOrigPoints == pData->iBucketCapacity) && !chart_layer_in_last_bucket(pData, x))
+    chart_layer_coarsen_buckets(pData);
+
+  if (!pData->iNumOrigPoints || !chart_layer_in_last_bucket(pData, x)) {
+    const unsigned int i = pData->iNumOrigPoints++;
+    pData->pXOrigData[i] = x;
+    pData->pYOrigData[i] = y;
+    pData->pYMinOrigData[i] = y;
+    pData->pYMaxOrigData[i] = y;
+    pData->pBucketCounts[i] = 1;
+    return;
+  }
+
+  // keep the means of the bucket running
+  const unsigned int i = pData->iNumOrigPoints - 1;
+  const unsigned int n = ++pData->pBucketCounts[i];
+  pData->pXOrigData[i] += (x - pData->pXOrigData[i]) / n;
+  pData->pYOrigData[i] += (y - pData->pYOrigData[i]) / n;
+  if (y < pData->pYMinOrigData[i])
+    pData->pYMinOrigData[i] = y;
+  if (y > pData->pYMaxOrigData[i])
+    pData->pYMaxOrigData[i] = y;
+}
+#endif
+
+// frees the previous data and makes space for iNumPoints new points with x-values,
+// or for buckets aggregating the points if they don't fit in the memory budget
+// the points are then added with chart_layer_store_point()
+static bool chart_layer_reserve_points(ChartLayerData* pData, const unsigned int iNumPoints) {
+#if PEBBLE_CHART_ENABLE_BUDGET
+  const size_t iBudget = chart_layer_data_budget(pData);
+  if (iNumPoints > iBudget / (2 * sizeof(float))) {
+    unsigned int iNumBuckets = iBudget / ((4 * sizeof(float)) + sizeof(unsigned int));
+    if (iNumBuckets < 2)
+      iNumBuckets = 2;
+
+    if (!chart_layer_reserve_data(pData, iNumBuckets, 1, true))
+      return false;
+    pData->pYMinOrigData = (float*) malloc(iNumBuckets * sizeof(float));
+    pData->pYMaxOrigData = (float*) malloc(iNumBuckets * sizeof(float));
+    pData->pBucketCounts = (unsigned int*) malloc(iNumBuckets * sizeof(unsigned int));
+    if (!pData->pYMinOrigData || !pData->pYMaxOrigData || !pData->pBucketCounts) {
+      chart_layer_reserve_data(pData, 0, 1, false);
+      return false;
+    }
+    pData->iNumOrigPoints = 0;
+    pData->iBucketCapacity = iNumBuckets;
+    pData->fBucketSpan = 0;
+    return true;
+  }
+#endif
+  return chart_layer_reserve_data(pData, iNumPoints, 1, true);
+}
+
+// stores the i-th point reserved by chart_layer_reserve_points()
+static void chart_layer_store_point(ChartLayerData* pData, const unsigned int i, const float x, const float y) {
+#if PEBBLE_CHART_ENABLE_BUDGET
+  if (pData->pYMinOrigData) {
+    chart_layer_push_bucket(pData, x, y);
+    return;
+  }
+#endif
+  pData->pXOrigData[i] = x;
+  pData->pYOrigData[i] = y;
+}
+
 // sets data into chart
 void chart_layer_set_data(ChartLayer* layer, 
 			  const void* pX, 
@@ -276,309 +823,2718 @@ void chart_layer_set_data(ChartLayer* layer,
     
     ChartLayerData* pData = get_chart_data(layer);
 
-    // clean up previous data
-    if (pData->iNumOrigPoints) {
-      free(pData->pXOrigData);
-      free(pData->pYOrigData);
-    }
-    
     // make space to copy data
-    pData->iNumOrigPoints = iNumPoints;
-    pData->pXOrigData = (float*) malloc(pData->iNumOrigPoints * sizeof(float));
-    pData->pYOrigData = (float*) malloc(pData->iNumOrigPoints * sizeof(float));
-
-    if (typeX == eINT) {
-      // cast
-      for (unsigned int i = 0; i < iNumPoints; ++i)
-	pData->pXOrigData[i] = (float)(((int*)pX)[i]);
-    }
-    else if (typeX == eFLOAT) {
-      memcpy(pData->pXOrigData, pX, iNumPoints * sizeof(float));
+    if (!chart_layer_reserve_points(pData, iNumPoints)) {
+      layer_mark_dirty(chart_layer_get_layer(layer));
+      return;
     }
 
-    if (typeY == eINT) {
-      // cast
+#if PEBBLE_CHART_ENABLE_BUDGET
+    // data over the memory budget is aggregated point by point
+    if (pData->pYMinOrigData) {
       for (unsigned int i = 0; i < iNumPoints; ++i)
-	pData->pYOrigData[i] = (float)(((int*)pY)[i]);
-    }
-    else if (typeY == eFLOAT) {
-      memcpy(pData->pYOrigData, pY, iNumPoints * sizeof(float));
+	chart_layer_push_bucket(pData, read_value(pX, typeX, i), read_value(pY, typeY, i));
+      layer_mark_dirty(chart_layer_get_layer(layer));
+      return;
     }
+#endif
+
+    copy_values(pData->pXOrigData, pX, typeX, iNumPoints);
+    copy_values(pData->pYOrigData, pY, typeY, iNumPoints);
 
     pData->bLayoutDirty = true;
     layer_mark_dirty(chart_layer_get_layer(layer));
   }
 }
 
-// heler struct for sorting x-axis values
-typedef struct {
-  float x_value;
-  int index;
-} ChartSortHelper;
+#if PEBBLE_CHART_ENABLE_SERIES
+// sets data with several y-values per point into chart
+void chart_layer_set_series_data(ChartLayer* layer,
+				 const void* pX,
+				 const ChartDataType typeX,
+				 const void* pY,
+				 const ChartDataType typeY,
+				 const unsigned int iNumPoints,
+				 const unsigned int iNumSeries) {
+  if (layer && iNumSeries && (iNumSeries <= CHART_MAX_SERIES)) {
+    ChartLayerData* pData = get_chart_data(layer);
 
-// helper comparator for sorting x-axis values
-static int cmpChartSortHelper(const void* a, const void* b) {
-  return ((const ChartSortHelper*)a)->x_value - ((const ChartSortHelper*)b)->x_value;
-}
+    if (chart_layer_reserve_data(pData, iNumPoints, iNumSeries, true)) {
+      copy_values(pData->pXOrigData, pX, typeX, iNumPoints);
+      copy_values(pData->pYOrigData, pY, typeY, iNumPoints * iNumSeries);
+    }
 
-// if needed, prepares data for drawing
-// this is where the heavy lifting is done
-static void chart_layer_update_layout(ChartLayer* layer) {
+    layer_mark_dirty(chart_layer_get_layer(layer));
+  }
+}
+#endif
+
+#if PEBBLE_CHART_ENABLE_HISTOGRAM
+// sets samples for histograms into chart
+void chart_layer_set_samples(ChartLayer* layer,
+			     const void* pSamples,
+			     const ChartDataType typeSamples,
+			     const unsigned int iNumSamples) {
   if (layer) {
-    
-    // if nothing to do, return
     ChartLayerData* pData = get_chart_data(layer);
-    if (!pData->bLayoutDirty)
-      return;
-    pData->bLayoutDirty = false;
-
-    // clear out previously cached values
-    if (pData->iNumPoints) {
-      free(pData->pXData);
-      free(pData->pYData);
-    }
-    pData->iNumPoints = 0;
-
-    if (pData->pXOrigData && pData->pYOrigData && pData->iNumOrigPoints) {
-      // figure out sort order
-      ChartSortHelper* sort_order = (ChartSortHelper*) malloc(pData->iNumOrigPoints * sizeof(ChartSortHelper));
-      for (unsigned int i = 0; i < pData->iNumOrigPoints; ++i)
-	sort_order[i] = ((ChartSortHelper) { .x_value = pData->pXOrigData[i], .index= i });
-      if (pData->typePlot != eSCATTER) {
-	qsort(sort_order, pData->iNumOrigPoints, sizeof(ChartSortHelper), &cmpChartSortHelper);
-      }
 
-      // figure out sampling rate
-      GRect bounds = layer_get_bounds(chart_layer_get_layer(layer));
-      const unsigned int iSampling = ((pData->typePlot == eSCATTER) || (((unsigned int)bounds.size.w - (2 * pData->iMargin)) > pData->iNumOrigPoints)) ? 1 : pData->iNumOrigPoints / ((unsigned int)bounds.size.w - (2 * pData->iMargin));
-
-      // init for cached data
-      pData->iNumPoints = pData->iNumOrigPoints / iSampling;
-      pData->pXData = (int*)malloc(pData->iNumPoints * sizeof(int));
-      pData->pYData = (int*)malloc(pData->iNumPoints * sizeof(int));
-      
-      // figure out Y-scale
-      float fMaxY = pData->pYOrigData[0];
-      float fMinY = pData->pYOrigData[0];
-      for (unsigned int i = 0; i < pData->iNumOrigPoints; i += iSampling) {
-	if (pData->pYOrigData[i] > fMaxY)
-	  fMaxY = pData->pYOrigData[i];
-	if (pData->pYOrigData[i] < fMinY)
-	  fMinY = pData->pYOrigData[i];
-      }
-      if (pData->fYMin != NOT_SET)
-	fMinY = pData->fYMin;
-      if (pData->fYMax != NOT_SET)
-	fMaxY = pData->fYMax;
-      const float fYScale = (float)(bounds.size.h - (2 * pData->iMargin)) / (fMaxY - fMinY); 
-
-      // calc Y values
-      for (unsigned int i = 0, j = 0; i < pData->iNumOrigPoints; i += iSampling, ++j) {
-	pData->pYData[j] = bounds.size.h - ((int)(fYScale * (pData->pYOrigData[sort_order[i].index] - fMinY)) + pData->iMargin);
-      }
+    // only y-values are stored
+    if (chart_layer_reserve_data(pData, iNumSamples, 1, false))
+      copy_values(pData->pYOrigData, pSamples, typeSamples, iNumSamples);
 
-      // x-axis position
-      pData->iYAxisIntercept = bounds.size.h - ((int)(fYScale * -fMinY) + pData->iMargin);
-
-      // calc y tick spacing
-      pData->iYTicks = (int)(fYScale * exponential10(closest_log10(fMaxY - fMinY)));
-
-      // figure out X-scale
-      float fMaxX = pData->pXOrigData[0];
-      float fMinX = pData->pXOrigData[0];
-      float fMinXSep = (pData->iNumOrigPoints > 1) ? pData->pXOrigData[sort_order[1].index] - pData->pXOrigData[sort_order[0].index] : 0;
-      for (unsigned int i = 0; i < pData->iNumOrigPoints; i += iSampling) {
-	if (pData->pXOrigData[i] > fMaxX)
-	  fMaxX = pData->pXOrigData[i];
-	if (pData->pXOrigData[i] < fMinX)
-	  fMinX = pData->pXOrigData[i];
-	if (i != 0) {
-	  if ((pData->pXOrigData[sort_order[i].index] - pData->pXOrigData[sort_order[i-1].index]) < fMinXSep)
-	    fMinXSep = pData->pXOrigData[sort_order[i].index] - pData->pXOrigData[sort_order[i-1].index];
-	}
-      }
-      if (pData->fXMin != NOT_SET)
-	fMinX = pData->fXMin;
-      if (pData->fXMax != NOT_SET)
-	fMaxX = pData->fXMax;
-      if (pData->typePlot != eBAR)
-	fMinXSep = 0;
-      const float fXScale = (float)(bounds.size.w - (2 * pData->iMargin)) / (fMaxX - fMinX + fMinXSep); 
-
-      // calc x values
-      for (unsigned int i = 0, j = 0; i < pData->iNumOrigPoints; i += iSampling, ++j) {
-	pData->pXData[j] = (int)(fXScale * (pData->pXOrigData[sort_order[i].index] - fMinX + fMinXSep/2)) + pData->iMargin;
-      }
+    layer_mark_dirty(chart_layer_get_layer(layer));
+  }
+}
+#endif
+
+// reads an unsigned LEB128 varint, advancing *ppPos
+// returns false if the varint runs past pEnd
+static bool read_varint(const uint8_t** ppPos, const uint8_t* pEnd, uint32_t* pValue) {
+  uint32_t value = 0;
+  for (int shift = 0; (shift < 35) && (*ppPos < pEnd); shift += 7) {
+    const uint8_t byte = *((*ppPos)++);
+    value |= (uint32_t)(byte & 0x7F) << shift;
+    if (!(byte & 0x80)) {
+      *pValue = value;
+      return true;
+    }
+  }
+  return false;
+}
 
-      // bar width
-      if (pData->typePlot == eBAR) {
-	pData->iBarWidth = (int)(fXScale * fMinXSep);
-	if (pData->iBarWidth > 2)
-	  pData->iBarWidth -= 2;
-      }
+// reads a zigzag-encoded signed varint, advancing *ppPos
+static bool read_svarint(const uint8_t** ppPos, const uint8_t* pEnd, int32_t* pValue) {
+  uint32_t value;
+  if (!read_varint(ppPos, pEnd, &value))
+    return false;
+  *pValue = (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+  return true;
+}
 
-      // y-axis position
-      pData->iXAxisIntercept = (int)(fXScale * -fMinX) + pData->iMargin;
+// decodes packed data straight into the chart's storage
+bool chart_layer_ingest_packed(ChartLayer* layer, const uint8_t* pPacked, const size_t iLength) {
+  if (!layer)
+    return false;
+
+  // x and y accumulate in unsigned, wrapping around on hostile input
+  // rather than overflowing
+  uint32_t iNumPoints = 0;
+  uint32_t x = 0;
+  int32_t dx = 0;
+  const uint8_t* pPos = NULL;
+  const uint8_t* pEnd = NULL;
+  bool bValid = pPacked && (iLength >= CHART_PACKED_HEADER_SIZE) && (pPacked[0] == CHART_PACKED_VERSION);
+  if (bValid) {
+    pPos = pPacked + CHART_PACKED_HEADER_SIZE;
+    pEnd = pPacked + iLength;
+    bValid = read_varint(&pPos, pEnd, &iNumPoints);
+  }
+  const uint8_t iFlags = bValid ? pPacked[1] : 0;
+  if (bValid && (iFlags & CHART_PACKED_UNIFORM_X)) {
+    int32_t iFirstX;
+    bValid = read_svarint(&pPos, pEnd, &iFirstX) && read_svarint(&pPos, pEnd, &dx);
+    x = (uint32_t)iFirstX;
+  }
 
-      // clean-up
-      pData->iPointsToDraw = 0;
-      free(sort_order);
+  // every sample takes at least one byte per encoded value,
+  // so a count larger than the payload means it is malformed
+  const size_t iMinSampleSize = (iFlags & CHART_PACKED_UNIFORM_X) ? 1 : 2;
+  bValid = bValid && (iNumPoints <= (size_t)(pEnd - pPos) / iMinSampleSize);
+
+  ChartLayerData* pData = get_chart_data(layer);
+  bValid = chart_layer_reserve_points(pData, bValid ? iNumPoints : 0) && bValid;
+  const float fXScale = bValid ? exponential10(-pPacked[2]) : 1;
+  const float fYScale = bValid ? exponential10(-pPacked[3]) : 1;
+
+  uint32_t y = 0;
+  for (unsigned int i = 0; bValid && (i < iNumPoints); ++i) {
+    int32_t delta;
+    if (iFlags & CHART_PACKED_UNIFORM_X) {
+      if (i)
+	x += (uint32_t)dx;
+    }
+    else {
+      bValid = read_svarint(&pPos, pEnd, &delta);
+      x += (uint32_t)delta;
     }
+    bValid = bValid && read_svarint(&pPos, pEnd, &delta);
+    y += (uint32_t)delta;
+
+    if (bValid)
+      chart_layer_store_point(pData, i, (int32_t)x * fXScale, (int32_t)y * fYScale);
   }
+
+  // don't show partially decoded data
+  if (!bValid)
+    chart_layer_reserve_data(pData, 0, 1, false);
+
+  layer_mark_dirty(chart_layer_get_layer(layer));
+  return bValid;
 }
 
-static void animation_started(Animation *animation, void *data) {
+#if PEBBLE_CHART_ENABLE_HISTORY
+// bit sizes of the values for each code, as in Gorilla
+// regular spacing repeats the x-delta, so the delta-of-delta is mostly 0,
+// while slowly changing y-values mostly fit in a few bits
+static const uint8_t s_aDeltaOfDeltaBits[HISTORY_NUM_CODES] = { 0, 7, 9, 12, 32 };
+static const uint8_t s_aDeltaYBits[HISTORY_NUM_CODES] = { 0, 4, 8, 16, 32 };
+
+// returns the smallest code whose bit size holds the value
+static unsigned int history_code(const int32_t value, const uint8_t* aBits) {
+  unsigned int iCode = 0;
+  while ((iCode < (HISTORY_NUM_CODES - 1)) &&
+	 (aBits[iCode] ? ((value < -(1 << (aBits[iCode] - 1))) || (value >= (1 << (aBits[iCode] - 1)))) : value))
+    ++iCode;
+  return iCode;
 }
 
-static void animation_stopped(Animation *animation, bool finished, void *l) {
+// returns the number of bits of the value with its prefix of iCode 1-bits,
+// ended by a 0-bit unless it is the last code
+static unsigned int history_code_bits(const unsigned int iCode, const uint8_t* aBits) {
+  return iCode + ((iCode < (HISTORY_NUM_CODES - 1)) ? 1 : 0) + aBits[iCode];
 }
 
-// called for each frame of the animation
-static void animation_update(Animation* animation, const uint32_t time_normalized) {
-  ChartLayer* layer = (ChartLayer*) animation_get_context(animation);
-  ChartLayerData* data = get_chart_data(layer);
+// writes the low iNumBits of value to the end of the block, most significant first
+static void history_write_bits(ChartHistoryBlock* pBlock, const uint32_t value, unsigned int iNumBits) {
+  while (iNumBits--) {
+    uint8_t* pByte = &pBlock->aEncoded[pBlock->iNumBits / 8];
+    const uint8_t mask = 0x80 >> (pBlock->iNumBits % 8);
+    if ((value >> iNumBits) & 1)
+      *pByte |= mask;
+    else
+      *pByte &= ~mask;
+    ++pBlock->iNumBits;
+  }
+}
 
-  // calculate num points to draw proportionally to percent of duration elapsed
-  if (time_normalized == ANIMATION_NORMALIZED_MAX)
-    data->iPointsToDraw = data->iNumPoints;
-  else
-    data->iPointsToDraw = (int) (data->iNumPoints * ((float)time_normalized/(float)ANIMATION_NORMALIZED_MAX));
-  
-  // trigger re-draw
-  layer_mark_dirty(chart_layer_get_layer(layer));
+// writes the value with its code prefix
+static void history_write_value(ChartHistoryBlock* pBlock, const int32_t value, const unsigned int iCode,
+				const uint8_t* aBits) {
+  history_write_bits(pBlock, (iCode < (HISTORY_NUM_CODES - 1)) ? (2u << iCode) - 2 : (1u << iCode) - 1,
+		     (iCode < (HISTORY_NUM_CODES - 1)) ? iCode + 1 : iCode);
+  history_write_bits(pBlock, (uint32_t)value, aBits[iCode]);
 }
 
-// function to draw chart
-static void chart_layer_update_func(Layer* l, GContext* ctx) {
-  ChartLayer* layer = (ChartLayer*)l;
-  chart_layer_update_layout(layer);
+// reads the next iNumBits of the block, most significant first
+static uint32_t history_read_bits(ChartHistoryCursor* pCursor, unsigned int iNumBits) {
+  uint32_t value = 0;
+  while (iNumBits--) {
+    const uint8_t byte = pCursor->pBlock->aEncoded[pCursor->iBitPos / 8];
+    value = (value << 1) | ((byte >> (7 - (pCursor->iBitPos % 8))) & 1);
+    ++pCursor->iBitPos;
+  }
+  return value;
+}
 
-  ChartLayerData* data = get_chart_data(layer);
+// reads a value with its code prefix, sign-extending it
+static int32_t history_read_value(ChartHistoryCursor* pCursor, const uint8_t* aBits) {
+  unsigned int iCode = 0;
+  while ((iCode < (HISTORY_NUM_CODES - 1)) && history_read_bits(pCursor, 1))
+    ++iCode;
+  const unsigned int iNumBits = aBits[iCode];
+  uint32_t value = history_read_bits(pCursor, iNumBits);
+  if (iNumBits && (iNumBits < 32) && ((value >> (iNumBits - 1)) & 1))
+    value |= ~0u << iNumBits;
+  return (int32_t)value;
+}
 
-  // handle animations
-  if ((data->iNumPoints != data->iPointsToDraw) && !animation_is_scheduled(data->pAnimation)) {
-    if (data->bAnimate) {
-      // do this here since duration is configurable
-      animation_set_duration(data->pAnimation, data->iAnimationDuration);
-      // kick off animation
-      animation_schedule(data->pAnimation);
+// positions cursor before the first sample of the block
+static void history_cursor_init(ChartHistoryCursor* pCursor, const ChartHistoryBlock* pBlock) {
+  pCursor->pBlock = pBlock;
+  pCursor->iBitPos = 0;
+  pCursor->iRemaining = pBlock->iNumSamples;
+  pCursor->x = pBlock->iFirstX;
+  pCursor->y = pBlock->iFirstY;
+  pCursor->dx = 0;
+}
+
+// decodes the next sample of the block, returns false when the block is exhausted
+// the deltas wrap around like they did when encoded
+static bool history_cursor_next(ChartHistoryCursor* pCursor, int32_t* pX, int32_t* pY) {
+  if (!pCursor->iRemaining)
+    return false;
+
+  // first sample is stored in the header
+  if (pCursor->iRemaining-- < pCursor->pBlock->iNumSamples) {
+    const int32_t dod = history_read_value(pCursor, s_aDeltaOfDeltaBits);
+    const int32_t dy = history_read_value(pCursor, s_aDeltaYBits);
+    pCursor->dx = (int32_t)((uint32_t)pCursor->dx + (uint32_t)dod);
+    pCursor->x = (int32_t)((uint32_t)pCursor->x + (uint32_t)pCursor->dx);
+    pCursor->y = (int32_t)((uint32_t)pCursor->y + (uint32_t)dy);
+  }
+
+  *pX = pCursor->x;
+  *pY = pCursor->y;
+  return true;
+}
+
+// gets the i-th oldest block in the ring
+static ChartHistoryBlock* history_get_block(ChartHistory* pHistory, const unsigned int i) {
+  return &pHistory->pBlocks[(pHistory->iFirstSeq + i) % pHistory->iCapacity];
+}
+
+// gets a block by its sequence number
+static ChartHistoryBlock* history_get_block_seq(ChartHistory* pHistory, const unsigned int iSeq) {
+  return &pHistory->pBlocks[iSeq % pHistory->iCapacity];
+}
+#endif
+
+#if PEBBLE_CHART_ENABLE_HISTORY || PEBBLE_CHART_ENABLE_OVERLAYS
+static bool deque_init(ChartDeque* pDeque, const unsigned int iCapacity) {
+  pDeque->pItems = (unsigned int*) malloc(iCapacity * sizeof(unsigned int));
+  pDeque->iCapacity = iCapacity;
+  pDeque->iHead = 0;
+  pDeque->iCount = 0;
+  return pDeque->pItems != NULL;
+}
+
+static unsigned int deque_front(const ChartDeque* pDeque) {
+  return pDeque->pItems[pDeque->iHead];
+}
+
+static unsigned int deque_back(const ChartDeque* pDeque) {
+  return pDeque->pItems[(pDeque->iHead + pDeque->iCount - 1) % pDeque->iCapacity];
+}
+
+static void deque_push_back(ChartDeque* pDeque, const unsigned int iItem) {
+  pDeque->pItems[(pDeque->iHead + pDeque->iCount++) % pDeque->iCapacity] = iItem;
+}
+
+static void deque_pop_back(ChartDeque* pDeque) {
+  --pDeque->iCount;
+}
+
+static void deque_pop_front(ChartDeque* pDeque) {
+  pDeque->iHead = (pDeque->iHead + 1) % pDeque->iCapacity;
+  --pDeque->iCount;
+}
+#endif
+
+#if PEBBLE_CHART_ENABLE_OVERLAYS
+static bool rolling_init(ChartRolling* pRolling, const unsigned int iWindow) {
+  *pRolling = (ChartRolling) { .iWindow = iWindow };
+  pRolling->pValues = (float*) malloc(iWindow * sizeof(float));
+  if (!pRolling->pValues ||
+      !deque_init(&pRolling->minDeque, iWindow) ||
+      !deque_init(&pRolling->maxDeque, iWindow)) {
+    rolling_free(pRolling);
+    return false;
+  }
+  return true;
+}
+
+static void rolling_free(ChartRolling* pRolling) {
+  free(pRolling->pValues);
+  free(pRolling->minDeque.pItems);
+  free(pRolling->maxDeque.pItems);
+  *pRolling = (ChartRolling) { .pValues = NULL };
+}
+
+static void rolling_reset(ChartRolling* pRolling) {
+  pRolling->iNumValues = 0;
+  pRolling->fSum = 0;
+  pRolling->minDeque.iCount = 0;
+  pRolling->maxDeque.iCount = 0;
+}
+
+// adds a value to the window, dropping the oldest value once the window is full
+static void rolling_push(ChartRolling* pRolling, const float value) {
+  const unsigned int iSeq = pRolling->iNumValues++;
+  float* pSlot = &pRolling->pValues[iSeq % pRolling->iWindow];
+
+  if (iSeq >= pRolling->iWindow)
+    pRolling->fSum -= *pSlot;
+  *pSlot = value;
+  pRolling->fSum += value;
+
+  // the running sum picks up rounding errors with every value added and
+  // dropped, so it is summed afresh from the window once per window
+  if (((iSeq + 1) % pRolling->iWindow) == 0) {
+    pRolling->fSum = 0;
+    for (unsigned int i = 0; i < pRolling->iWindow; ++i)
+      pRolling->fSum += pRolling->pValues[i];
+  }
+  pRolling->fExpAverage = iSeq ? pRolling->fExpAverage + ((2 * (value - pRolling->fExpAverage)) / (pRolling->iWindow + 1)) : value;
+
+  // keep deques monotonic, with only values from the window
+  ChartDeque* pMin = &pRolling->minDeque;
+  if (pMin->iCount && ((deque_front(pMin) + pRolling->iWindow) <= iSeq))
+    deque_pop_front(pMin);
+  while (pMin->iCount && (pRolling->pValues[deque_back(pMin) % pRolling->iWindow] >= value))
+    deque_pop_back(pMin);
+  deque_push_back(pMin, iSeq);
+
+  ChartDeque* pMax = &pRolling->maxDeque;
+  if (pMax->iCount && ((deque_front(pMax) + pRolling->iWindow) <= iSeq))
+    deque_pop_front(pMax);
+  while (pMax->iCount && (pRolling->pValues[deque_back(pMax) % pRolling->iWindow] <= value))
+    deque_pop_back(pMax);
+  deque_push_back(pMax, iSeq);
+}
+
+static float rolling_average(const ChartRolling* pRolling, const ChartAverageType typeAverage) {
+  if (typeAverage == eEXPONENTIAL_AVERAGE)
+    return pRolling->fExpAverage;
+  return pRolling->fSum / ((pRolling->iNumValues < pRolling->iWindow) ? pRolling->iNumValues : pRolling->iWindow);
+}
+
+static float rolling_min(const ChartRolling* pRolling) {
+  return pRolling->pValues[deque_front(&pRolling->minDeque) % pRolling->iWindow];
+}
+
+static float rolling_max(const ChartRolling* pRolling) {
+  return pRolling->pValues[deque_front(&pRolling->maxDeque) % pRolling->iWindow];
+}
+#endif
+
+#if PEBBLE_CHART_ENABLE_HISTORY
+// updates the min/max deques after the newest block (iSeq) changed,
+// so that their fronts hold the blocks with the overall minimum/maximum y-value
+static void history_track_extremes(ChartHistory* pHistory, const unsigned int iSeq) {
+  const ChartHistoryBlock* pBlock = history_get_block_seq(pHistory, iSeq);
+
+  ChartDeque* pMin = &pHistory->minDeque;
+  if (pMin->iCount && (deque_back(pMin) == iSeq))
+    deque_pop_back(pMin);
+  while (pMin->iCount && (history_get_block_seq(pHistory, deque_back(pMin))->iMinY >= pBlock->iMinY))
+    deque_pop_back(pMin);
+  deque_push_back(pMin, iSeq);
+
+  ChartDeque* pMax = &pHistory->maxDeque;
+  if (pMax->iCount && (deque_back(pMax) == iSeq))
+    deque_pop_back(pMax);
+  while (pMax->iCount && (history_get_block_seq(pHistory, deque_back(pMax))->iMaxY <= pBlock->iMaxY))
+    deque_pop_back(pMax);
+  deque_push_back(pMax, iSeq);
+}
+
+// maps a newly appended sample into the cached layout if it doesn't require
+// a change of scale, returns false if a full relayout is needed instead
+static bool chart_layer_append_to_layout(ChartLayer* layer, const int x, const int y) {
+  ChartLayerData* pData = get_chart_data(layer);
+  if (pData->bLayoutDirty || is_bar_plot(pData->typePlot) || !pData->iNumPoints || !pData->iSampling)
+    return false;
+
+  // beyond a pinned x-axis range, points are culled once
+  // the neighbour running the line to the edge of the plot is in place
+  GRect bounds = layer_get_bounds(chart_layer_get_layer(layer));
+  if ((pData->fXMax != NOT_SET) && (x > pData->fXMax) &&
+      (pData->pXData[pData->iNumPoints - 1] >= (bounds.size.w - pData->iMargin)))
+    return true;
+
+  if ((x < pData->fLayoutXMin) || (x > pData->fLayoutXMax) ||
+      (y < pData->fLayoutYMin) || (y > pData->fLayoutYMax))
+    return false;
+
+  // only every iSampling-th sample is drawn,
+  // but all of them count towards the overlays
+  chart_layer_push_overlays(pData, y);
+  if (pData->iNumSampled++ % pData->iSampling)
+    return true;
+  if (pData->iNumPoints >= pData->iPointCapacity)
+    return false;
+
+  chart_layer_map_overlays(pData, bounds, pData->iNumPoints);
+  const bool bWasDrawn = (pData->iPointsToDraw == pData->iNumPoints);
+  pData->pXData[pData->iNumPoints] = (int)(pData->fXScale * (x - pData->fLayoutXMin)) + pData->iMargin;
+  pData->pYData[pData->iNumPoints] = bounds.size.h - ((int)(pData->fYScale * (y - pData->fLayoutYMin)) + pData->iMargin);
+  ++pData->iNumPoints;
+  if (bWasDrawn)
+    pData->iPointsToDraw = pData->iNumPoints;
+  return true;
+}
+
+bool chart_layer_set_history_capacity(ChartLayer* layer, const unsigned int iNumBlocks) {
+  if (!layer)
+    return false;
+
+  // history replaces any data set through chart_layer_set_data,
+  // and starts out with a new autoscaled range
+  ChartLayerData* pData = get_chart_data(layer);
+  chart_layer_reserve_data(pData, 0, 1, false);
+  pData->fAutoXMin = NOT_SET;
+  pData->fAutoXMax = NOT_SET;
+  pData->fAutoYMin = NOT_SET;
+  pData->fAutoYMax = NOT_SET;
+  layer_mark_dirty(chart_layer_get_layer(layer));
+
+  if (iNumBlocks) {
+    pData->history.pBlocks = (ChartHistoryBlock*) malloc(iNumBlocks * sizeof(ChartHistoryBlock));
+    if (!pData->history.pBlocks ||
+	!deque_init(&pData->history.minDeque, iNumBlocks) ||
+	!deque_init(&pData->history.maxDeque, iNumBlocks)) {
+      chart_layer_reserve_data(pData, 0, 1, false);
+      return false;
     }
-    else {
-      // cause entire chart to be drawn
-      data->iPointsToDraw = data->iNumPoints;
+    pData->history.iCapacity = iNumBlocks;
+  }
+  return true;
+}
+
+bool chart_layer_append_point(ChartLayer* layer, const int x, const int y) {
+  if (!layer)
+    return false;
+
+  ChartLayerData* pData = get_chart_data(layer);
+  ChartHistory* pHistory = &pData->history;
+  if (!pHistory->pBlocks || (pHistory->iNumSamples && (x < pHistory->iLastX)))
+    return false;
+
+  ChartHistoryBlock* pBlock = pHistory->iNumBlocks ? history_get_block(pHistory, pHistory->iNumBlocks - 1) : NULL;
+  const int32_t dx = (int32_t)((uint32_t)x - (uint32_t)pHistory->iLastX);
+  const int32_t dod = (int32_t)((uint32_t)dx - (uint32_t)pHistory->iLastDX);
+  const int32_t dy = (int32_t)((uint32_t)y - (uint32_t)pHistory->iLastY);
+  const unsigned int iDodCode = history_code(dod, s_aDeltaOfDeltaBits);
+  const unsigned int iDYCode = history_code(dy, s_aDeltaYBits);
+  const unsigned int iNumBits = history_code_bits(iDodCode, s_aDeltaOfDeltaBits) + history_code_bits(iDYCode, s_aDeltaYBits);
+  bool bEvicted = false;
+  if (pBlock && ((pBlock->iNumBits + iNumBits) <= (HISTORY_BLOCK_SIZE * 8)) && (pBlock->iNumSamples < UINT16_MAX)) {
+    // append to current block
+    history_write_value(pBlock, dod, iDodCode, s_aDeltaOfDeltaBits);
+    history_write_value(pBlock, dy, iDYCode, s_aDeltaYBits);
+    ++pBlock->iNumSamples;
+    pHistory->iLastDX = dx;
+  }
+  else {
+    // start a new block, evicting the oldest one if the ring is full
+    if (pHistory->iNumBlocks == pHistory->iCapacity) {
+      pHistory->iNumSamples -= history_get_block(pHistory, 0)->iNumSamples;
+      if (deque_front(&pHistory->minDeque) == pHistory->iFirstSeq)
+	deque_pop_front(&pHistory->minDeque);
+      if (deque_front(&pHistory->maxDeque) == pHistory->iFirstSeq)
+	deque_pop_front(&pHistory->maxDeque);
+      ++pHistory->iFirstSeq;
+      --pHistory->iNumBlocks;
+      bEvicted = true;
     }
+    pBlock = history_get_block(pHistory, pHistory->iNumBlocks++);
+    *pBlock = (ChartHistoryBlock) {
+      .iFirstX = x,
+      .iFirstY = y,
+      .iMinY = y,
+      .iMaxY = y,
+      .iNumSamples = 1,
+      .iNumBits = 0
+    };
+    pHistory->iLastDX = 0;
   }
-  
-  GRect bounds = layer_get_bounds(l);
 
-  // draw background
-  GRect canvas = (GRect) { .origin = { 0, 0 },
-			   .size = { bounds.size.w-1, bounds.size.h-1 } };
-  graphics_context_set_fill_color(ctx, data->clrCanvas);
-  graphics_fill_rect(ctx, canvas, 0, 0);
+  pBlock->iLastX = x;
+  if (y < pBlock->iMinY)
+    pBlock->iMinY = y;
+  if (y > pBlock->iMaxY)
+    pBlock->iMaxY = y;
+  history_track_extremes(pHistory, pHistory->iFirstSeq + pHistory->iNumBlocks - 1);
+  pHistory->iLastX = x;
+  pHistory->iLastY = y;
+  ++pHistory->iNumSamples;
+
+  // most samples land within the current axis ranges,
+  // in which case only the new sample needs mapping
+  if (bEvicted || !chart_layer_append_to_layout(layer, x, y))
+    pData->bLayoutDirty = true;
+  layer_mark_dirty(chart_layer_get_layer(layer));
+  return true;
+}
+#endif
 
-  // set color for rest of draw cycle
-  graphics_context_set_fill_color(ctx, data->clrPlot);
-  graphics_context_set_stroke_color(ctx, data->clrPlot);
-  graphics_context_set_text_color(ctx, data->clrPlot);
-  
-  // draw frame
-  if (data->bShowFrame)
-    graphics_draw_rect(ctx, canvas);
+// helper comparator for sorting x-axis values
+static int cmpChartSortHelper(const void* a, const void* b) {
+  const float fA = ((const ChartSortHelper*)a)->x_value;
+  const float fB = ((const ChartSortHelper*)b)->x_value;
+  return (fA > fB) - (fA < fB);
+}
 
-  if (data->iNumPoints) {
-    // x-axis
-    graphics_draw_line(ctx,
-		       ((GPoint) {
-			 .x = data->iMargin,
-			   .y = data->iYAxisIntercept }),
-		       ((GPoint) { 
-			 .x = bounds.size.w - data->iMargin,
-			   .y = data->iYAxisIntercept }));
-    
-    // y-axis major ticks
-    for (int i = data->iYAxisIntercept; i <= (bounds.size.h - data->iMargin); i += data->iYTicks)
-      graphics_draw_line(ctx,
-			 ((GPoint) {
-			   .x = data->iMargin,
-			     .y = i }),
-			 ((GPoint) {
-			   .x = data->iMargin + 4,
-			     .y = i }));
-    for (int i = data->iYAxisIntercept; i > data->iMargin; i -= data->iYTicks)
-      graphics_draw_line(ctx,
-			 ((GPoint) {
-			   .x = data->iMargin,
-			     .y = i }),
-			 ((GPoint) {
-			   .x = data->iMargin + 4,
-			     .y = i }));
-
-    // y-axis minor ticks
-    for (int i = data->iYAxisIntercept + (data->iYTicks / 2); i <= (bounds.size.h - data->iMargin); i += data->iYTicks)
-      graphics_draw_line(ctx,
-			 ((GPoint) {
-			   .x = data->iMargin,
-			     .y = i }),
-			 ((GPoint) {
-			   .x = data->iMargin + 2,
-			     .y = i }));
-    for (int i = data->iYAxisIntercept - (data->iYTicks / 2); i > data->iMargin; i -= data->iYTicks)
-      graphics_draw_line(ctx,
-			 ((GPoint) {
-			   .x = data->iMargin,
-			     .y = i }),
-			 ((GPoint) {
-			   .x = data->iMargin + 2,
-			     .y = i }));
+// maps a y-value to its pixel position with the cached scale
+static int chart_layer_map_y(const ChartLayerData* pData, const GRect bounds, const float y) {
+  return bounds.size.h - ((int)(pData->fYScale * (y - pData->fLayoutYMin)) + pData->iMargin);
+}
 
-    // y-axis
-    graphics_draw_line(ctx,
-		       ((GPoint) {
-			 .x = data->iXAxisIntercept,
-			   .y = data->iMargin }),
-		       ((GPoint) { 
-			 .x = data->iXAxisIntercept,
-			   .y = bounds.size.h - data->iMargin }));
-
-    // main plot
-    const bool bShowPoints = (data->typePlot != eBAR) && ((data->typePlot == eSCATTER) || (data->bShowPoints && (data->iNumOrigPoints < ((unsigned int)bounds.size.w / 3))));
-    const uint16_t iPointRadius = ((data->typePlot == eLINE) || (data->iNumOrigPoints < ((unsigned int)bounds.size.w / 3))) ? 3 : 2;
-    for (unsigned int i = 0; i < data->iPointsToDraw; ++i) {
-      if ((data->typePlot == eLINE) && (i != data->iNumPoints-1)) {
-	graphics_draw_line(ctx, 
-			   ((GPoint) { 
-			     .x = data->pXData[i],
-			       .y = data->pYData[i] }),
-			   ((GPoint) {
-			     .x = data->pXData[i+1],
-			       .y = data->pYData[i+1] }));
-      }
-      else if (data->typePlot == eBAR) {
-	graphics_fill_rect(ctx,
-			   ((GRect) {
-			     .origin = { data->pXData[i] - (data->iBarWidth / 2), data->pYData[i] },
-			       .size = { data->iBarWidth, (((data->iYAxisIntercept > (bounds.size.h - data->iMargin)) ? (bounds.size.h - data->iMargin) : data->iYAxisIntercept) - data->pYData[i]) } }),
-			   0,
-			   GCornersAll);
-      }
+#if PEBBLE_CHART_ENABLE_OVERLAYS
+static void chart_layer_free_overlay_cache(ChartLayerData* pData) {
+  free(pData->pAverageData);
+  free(pData->pBandMinData);
+  free(pData->pBandMaxData);
+  pData->pAverageData = NULL;
+  pData->pBandMinData = NULL;
+  pData->pBandMaxData = NULL;
+}
+#else
+// overlays are compiled out, so there is never anything to cache
+static void chart_layer_free_overlay_cache(ChartLayerData* pData) {
+}
+#endif
+
+// frees the cached layout, leaving the chart with nothing to draw
+static void chart_layer_free_layout_cache(ChartLayerData* pData) {
+  free(pData->pXData);
+  free(pData->pYData);
+  pData->pXData = NULL;
+  pData->pYData = NULL;
+#if PEBBLE_CHART_ENABLE_SERIES
+  free(pData->pYBaseData);
+  pData->pYBaseData = NULL;
+#endif
+#if PEBBLE_CHART_ENABLE_CURSOR
+  free(pData->pSortOrder);
+  pData->pSortOrder = NULL;
+#endif
+  pData->iNumPoints = 0;
+  pData->iPointCapacity = 0;
+  chart_layer_free_overlay_cache(pData);
+#if PEBBLE_CHART_ENABLE_ANIMATION
+  free(pData->pMorphData);
+  pData->pMorphData = NULL;
+  pData->iNumMorphPoints = 0;
+#endif
+}
 
-      if (bShowPoints) {
-	graphics_fill_circle(ctx, 
-			     ((GPoint) {
-			       .x = data->pXData[i],
-				 .y = data->pYData[i] } ), iPointRadius);
-      }
+#if PEBBLE_CHART_ENABLE_ANIMATION || PEBBLE_CHART_ENABLE_PERSIST
+// true if the layout has a base for each bar, as for series data
+static bool chart_layer_has_bar_bases(const ChartLayerData* pData) {
+#if PEBBLE_CHART_ENABLE_SERIES
+  return pData->pYBaseData != NULL;
+#else
+  return false;
+#endif
+}
+#endif
+
+#if PEBBLE_CHART_ENABLE_OVERLAYS
+// makes space for the overlays of iCapacity points and resets the rolling statistics
+// overlays are only drawn when the points are in x-order, so not for scatter plots
+static void chart_layer_alloc_overlay_cache(ChartLayerData* pData, const unsigned int iCapacity) {
+  chart_layer_free_overlay_cache(pData);
+  if (!pData->rolling.pValues || (pData->typePlot == eSCATTER))
+    return;
+
+  rolling_reset(&pData->rolling);
+  if (pData->typeAverage != eNO_AVERAGE)
+    pData->pAverageData = (int*)malloc(iCapacity * sizeof(int));
+  if (pData->bShowBand) {
+    pData->pBandMinData = (int*)malloc(iCapacity * sizeof(int));
+    pData->pBandMaxData = (int*)malloc(iCapacity * sizeof(int));
+    if (!pData->pBandMinData || !pData->pBandMaxData) {
+      free(pData->pBandMinData);
+      free(pData->pBandMaxData);
+      pData->pBandMinData = NULL;
+      pData->pBandMaxData = NULL;
     }
   }
 }
 
+// caches the current rolling statistics as overlay point i
+static void chart_layer_map_overlays(ChartLayerData* pData, const GRect bounds, const unsigned int i) {
+  if (pData->pAverageData)
+    pData->pAverageData[i] = chart_layer_map_y(pData, bounds, rolling_average(&pData->rolling, pData->typeAverage));
+  if (pData->pBandMinData) {
+    pData->pBandMinData[i] = chart_layer_map_y(pData, bounds, rolling_min(&pData->rolling));
+    pData->pBandMaxData[i] = chart_layer_map_y(pData, bounds, rolling_max(&pData->rolling));
+  }
+}
+
+// true if the layout has overlays to draw
+static bool chart_layer_has_overlays(const ChartLayerData* pData) {
+  return pData->pAverageData || pData->pBandMinData;
+}
+
+// feeds a value to the rolling statistics, if there are overlays to draw
+static void chart_layer_push_overlays(ChartLayerData* pData, const float y) {
+  if (chart_layer_has_overlays(pData))
+    rolling_push(&pData->rolling, y);
+}
+#else
+static void chart_layer_alloc_overlay_cache(ChartLayerData* pData, const unsigned int iCapacity) {
+}
+
+static bool chart_layer_has_overlays(const ChartLayerData* pData) {
+  return false;
+}
+
+static void chart_layer_map_overlays(ChartLayerData* pData, const GRect bounds, const unsigned int i) {
+}
+
+static void chart_layer_push_overlays(ChartLayerData* pData, const float y) {
+}
+#endif
+
+// rounds value down, or up, to a multiple of step
+static float round_to_step(const float value, const float step, const bool bUp) {
+  float f = (float)((int)(value / step)) * step;
+  if (bUp && (f < value))
+    f += step;
+  else if (!bUp && (f > value))
+    f -= step;
+  return f;
+}
+
+// returns the largest step of 1, 2 or 5 times a power of ten, which is at most fLimit
+static float nice_step(const float fLimit) {
+  const float fDecade = exponential10(closest_log10(fLimit));
+  if ((10 * fDecade) <= fLimit)
+    return 10 * fDecade;
+  if ((5 * fDecade) <= fLimit)
+    return 5 * fDecade;
+  if ((2 * fDecade) <= fLimit)
+    return 2 * fDecade;
+  return fDecade;
+}
+
+// widens an empty range, e.g. of constant data, by a step to either side,
+// so that the scale mapping it to pixels stays finite
+static void widen_empty_range(float* pMin, float* pMax) {
+  if (*pMax != *pMin)
+    return;
+  const float fStep = exponential10(closest_log10((*pMin < 0) ? -*pMin : *pMin));
+  *pMin -= fStep;
+  *pMax += fStep;
+}
+
+// replaces the data range [*pMin, *pMax] with the autoscaled axis range
+// the previous range (*pAutoMin, *pAutoMax) is kept while the data fits
+// within it and the data, with its headroom, fills at least half of it;
+// otherwise a new range is chosen with fHeadroom * span of extra space above
+// the data (and below it if bPadMin), rounded out to a step of about a fifth
+// of the padded span, which is small enough for the new range to be kept
+static void autoscale_axis(const float fHeadroom, const bool bPadMin,
+			   float* pMin, float* pMax, float* pAutoMin, float* pAutoMax) {
+  const float fSpan = *pMax - *pMin;
+  const float fPad = fHeadroom * fSpan;
+  const float fRange = fSpan + (bPadMin ? 2 : 1) * fPad;
+  if ((*pAutoMin == NOT_SET) || (*pMin < *pAutoMin) || (*pMax > *pAutoMax) ||
+      ((2 * fRange) < (*pAutoMax - *pAutoMin))) {
+    const float fStep = (fRange > 0) ? nice_step(fRange / 5) : 1;
+    *pAutoMin = round_to_step(*pMin - (bPadMin ? fPad : 0), fStep, false);
+    *pAutoMax = round_to_step(*pMax + fPad, fStep, true);
+    widen_empty_range(pAutoMin, pAutoMax);
+  }
+  *pMin = *pAutoMin;
+  *pMax = *pAutoMax;
+}
+
+// converts a pixel offset to int, limited to [iLow, iHigh] with a whole number
+// of steps, so that an axis far outside of the plot stays in range of the
+// drawing calls, and its ticks still line up with the data
+static int clamp_to_steps(const float fOffset, const int iLow, const int iHigh, const int iStep) {
+  if ((fOffset < -1e9f) || (fOffset > 1e9f))
+    return (fOffset < 0) ? iLow : iHigh;
+  const int iOffset = (int)fOffset;
+  if (iOffset < iLow)
+    return iLow - ((iLow - iOffset) % iStep);
+  if (iOffset > iHigh)
+    return iHigh + ((iOffset - iHigh) % iStep);
+  return iOffset;
+}
+
+// caches the axis positions, tick spacing and bar width for the given scales
+static void chart_layer_set_axes(ChartLayerData* pData, const GRect bounds,
+				 const float fMinX, const float fMaxX, const float fXScale, const float fMinXSep,
+				 const float fMinY, const float fMaxY, const float fYScale) {
+  // keep scale for mapping further points
+  pData->fLayoutXMin = fMinX;
+  pData->fLayoutXMax = fMaxX;
+  pData->fLayoutYMin = fMinY;
+  pData->fLayoutYMax = fMaxY;
+  pData->fXScale = fXScale;
+  pData->fYScale = fYScale;
+  pData->fLayoutXSep = fMinXSep;
+
+  // calc y tick spacing
+  pData->iYTicks = (int)(fYScale * exponential10(closest_log10(fMaxY - fMinY)));
+  if (pData->iYTicks < 1)
+    pData->iYTicks = 1;
+
+  // x-axis position, kept within about a screen height of the bounds
+  pData->iYAxisIntercept = bounds.size.h - (clamp_to_steps(fYScale * -fMinY, -bounds.size.h, 2 * bounds.size.h,
+							   pData->iYTicks) + pData->iMargin);
+
+  // bar width
+  if (is_bar_plot(pData->typePlot)) {
+    pData->iBarWidth = (int)(fXScale * fMinXSep);
+    if (pData->iBarWidth > 2)
+      pData->iBarWidth -= 2;
+  }
+
+  // y-axis position, kept within about a screen width of the bounds
+  pData->iXAxisIntercept = clamp_to_steps(fXScale * -fMinX, -bounds.size.w, 2 * bounds.size.w, 1) + pData->iMargin;
+}
+
+// keeps the x-sorted order of the points for cursor lookups, or frees it
+static void chart_layer_keep_sort_order(ChartLayerData* pData, ChartSortHelper* sort_order) {
+#if PEBBLE_CHART_ENABLE_CURSOR
+  pData->pSortOrder = sort_order;
+#else
+  free(sort_order);
+#endif
+}
+
+#if PEBBLE_CHART_ENABLE_HISTORY
+// lays out the samples of the history store
+// scales come from the block headers, so only the blocks
+// within the x-axis range are decoded
+// bWasDrawn is set if the previous layout was completely drawn
+static void chart_layer_update_history_layout(ChartLayer* layer, const bool bWasDrawn) {
+  ChartLayerData* pData = get_chart_data(layer);
+  ChartHistory* pHistory = &pData->history;
+  if (!pHistory->iNumSamples || (is_bar_plot(pData->typePlot) && (pData->typePlot != eBAR)))
+    return;
+
+  // figure out X-range
+  float fMinX = history_get_block(pHistory, 0)->iFirstX;
+  float fMaxX = pHistory->iLastX;
+  if (pData->bAutoscale)
+    autoscale_axis(pData->fAutoscaleHeadroom, false, &fMinX, &fMaxX, &pData->fAutoXMin, &pData->fAutoXMax);
+  if (pData->fXMin != NOT_SET)
+    fMinX = pData->fXMin;
+  if (pData->fXMax != NOT_SET)
+    fMaxX = pData->fXMax;
+
+  // figure out Y-range and number of samples,
+  // the deques track the Y-range of the whole history
+  unsigned int iNumVisible = pHistory->iNumSamples;
+  float fMinY = history_get_block_seq(pHistory, deque_front(&pHistory->minDeque))->iMinY;
+  float fMaxY = history_get_block_seq(pHistory, deque_front(&pHistory->maxDeque))->iMaxY;
+  if ((pData->fXMin != NOT_SET) || (pData->fXMax != NOT_SET)) {
+    // only use the blocks within the x-axis range
+    iNumVisible = 0;
+    for (unsigned int b = 0; b < pHistory->iNumBlocks; ++b) {
+      const ChartHistoryBlock* pBlock = history_get_block(pHistory, b);
+      if ((pBlock->iLastX < fMinX) || (pBlock->iFirstX > fMaxX))
+	continue;
+      if (!iNumVisible || (pBlock->iMinY < fMinY))
+	fMinY = pBlock->iMinY;
+      if (!iNumVisible || (pBlock->iMaxY > fMaxY))
+	fMaxY = pBlock->iMaxY;
+      iNumVisible += pBlock->iNumSamples;
+    }
+    if (!iNumVisible)
+      return;
+  }
+  if (pData->bAutoscale)
+    autoscale_axis(pData->fAutoscaleHeadroom, true, &fMinY, &fMaxY, &pData->fAutoYMin, &pData->fAutoYMax);
+  if (pData->fYMin != NOT_SET)
+    fMinY = pData->fYMin;
+  if (pData->fYMax != NOT_SET)
+    fMaxY = pData->fYMax;
+
+  // figure out sampling rate
+  GRect bounds = layer_get_bounds(chart_layer_get_layer(layer));
+  const unsigned int iPlotWidth = (unsigned int)bounds.size.w - (2 * pData->iMargin);
+  const unsigned int iSampling = ((pData->typePlot == eSCATTER) || (iPlotWidth > iNumVisible)) ? 1 : iNumVisible / iPlotWidth;
+
+  // samples are evenly spaced in most histories, so use the
+  // average spacing rather than decoding everything to find the minimum
+  const float fMinXSep = ((pData->typePlot == eBAR) && (pHistory->iNumSamples > 1)) ?
+    (float)(pHistory->iLastX - history_get_block(pHistory, 0)->iFirstX) / (pHistory->iNumSamples - 1) : 0;
+
+  widen_empty_range(&fMinY, &fMaxY);
+  if (!fMinXSep)
+    widen_empty_range(&fMinX, &fMaxX);
+  const float fYScale = (float)(bounds.size.h - (2 * pData->iMargin)) / (fMaxY - fMinY);
+  const float fXScale = (float)iPlotWidth / (fMaxX - fMinX + fMinXSep);
+  chart_layer_set_axes(pData, bounds, fMinX, fMaxX, fXScale, fMinXSep, fMinY, fMaxY, fYScale);
+
+  // init for cached data
+  // leave room for appending samples without a relayout
+  const unsigned int iMaxPoints = (iNumVisible + iSampling - 1) / iSampling;
+  pData->iPointCapacity = iMaxPoints + (iPlotWidth / 2);
+  pData->iSampling = iSampling;
+  pData->iNumSampled = iNumVisible;
+  pData->pXData = (int*)malloc(pData->iPointCapacity * sizeof(int));
+  pData->pYData = (int*)malloc(pData->iPointCapacity * sizeof(int));
+  if (!pData->pXData || !pData->pYData) {
+    chart_layer_free_layout_cache(pData);
+    return;
+  }
+  chart_layer_alloc_overlay_cache(pData, pData->iPointCapacity);
+
+  // decode visible blocks, calculating x and y values
+  // samples outside of the x-axis range are culled, apart from the
+  // neighbours just outside of it, so that lines run to the edge of the plot
+  unsigned int iSample = 0;
+  bool bPending = false;
+  bool bDone = false;
+  int32_t iPendingX = 0, iPendingY = 0;
+  for (unsigned int b = 0; (b < pHistory->iNumBlocks) && !bDone; ++b) {
+    const ChartHistoryBlock* pBlock = history_get_block(pHistory, b);
+    if ((pBlock->iLastX < fMinX) || (pBlock->iFirstX > fMaxX))
+      continue;
+
+    ChartHistoryCursor cursor;
+    int32_t x, y;
+    history_cursor_init(&cursor, pBlock);
+    while (!bDone && history_cursor_next(&cursor, &x, &y)) {
+      chart_layer_push_overlays(pData, y);
+      if (x < fMinX) {
+	iPendingX = x;
+	iPendingY = y;
+	bPending = true;
+	continue;
+      }
+      bDone = (x > fMaxX);
+      if (bPending && (pData->iNumPoints < iMaxPoints)) {
+	pData->pXData[pData->iNumPoints] = (int)(fXScale * (iPendingX - fMinX + fMinXSep/2)) + pData->iMargin;
+	pData->pYData[pData->iNumPoints] = chart_layer_map_y(pData, bounds, iPendingY);
+	chart_layer_map_overlays(pData, bounds, pData->iNumPoints);
+	++pData->iNumPoints;
+	bPending = false;
+      }
+      if ((iSample++ % iSampling) || (pData->iNumPoints >= iMaxPoints))
+	continue;
+      pData->pXData[pData->iNumPoints] = (int)(fXScale * (x - fMinX + fMinXSep/2)) + pData->iMargin;
+      pData->pYData[pData->iNumPoints] = chart_layer_map_y(pData, bounds, y);
+      chart_layer_map_overlays(pData, bounds, pData->iNumPoints);
+      ++pData->iNumPoints;
+    }
+  }
+
+  // appending to a chart which is already drawn shouldn't replay the animation
+  pData->iPointsToDraw = bWasDrawn ? pData->iNumPoints : 0;
+}
+#endif
+
+#if PEBBLE_CHART_ENABLE_HISTOGRAM
+// bins the y-values into bars, one linear pass without sorting
+// the x-axis range is that of the values, unless pinned
+static void chart_layer_update_histogram_layout(ChartLayer* layer) {
+  ChartLayerData* pData = get_chart_data(layer);
+  const float* pValues = pData->pYOrigData;
+
+  // figure out X-range
+  float fMinX = pValues[0];
+  float fMaxX = pValues[0];
+  if ((pData->fXMin == NOT_SET) || (pData->fXMax == NOT_SET)) {
+    for (unsigned int i = 1; i < pData->iNumOrigPoints; ++i) {
+      if (pValues[i] < fMinX)
+	fMinX = pValues[i];
+      if (pValues[i] > fMaxX)
+	fMaxX = pValues[i];
+    }
+  }
+  if (pData->fXMin != NOT_SET)
+    fMinX = pData->fXMin;
+  if (pData->fXMax != NOT_SET)
+    fMaxX = pData->fXMax;
+  if (fMaxX <= fMinX)
+    fMaxX = fMinX + 1;
+
+  // one bin per HISTOGRAM_BIN_WIDTH pixels unless set, and no more than one per pixel
+  GRect bounds = layer_get_bounds(chart_layer_get_layer(layer));
+  const int iPlotWidth = bounds.size.w - (2 * pData->iMargin);
+  unsigned int iNumBins = pData->iHistogramBins ? pData->iHistogramBins : (unsigned int)iPlotWidth / HISTOGRAM_BIN_WIDTH;
+  if (iNumBins > (unsigned int)iPlotWidth)
+    iNumBins = iPlotWidth;
+  if (!iNumBins)
+    return;
+
+  // pYData holds the bin counts until they are scaled
+  pData->pXData = (int*)malloc(iNumBins * sizeof(int));
+  pData->pYData = (int*)calloc(iNumBins, sizeof(int));
+  if (!pData->pXData || !pData->pYData) {
+    chart_layer_free_layout_cache(pData);
+    return;
+  }
+  pData->iNumPoints = iNumBins;
+  pData->iPointCapacity = iNumBins;
+
+  // count, the samples are kept as floats, so each bin index takes a multiply
+  // by the bins per unit and a truncation, without a division or floor()
+  // the maximum, and any rounding up next to it, falls into the last bin
+  const float fBinScale = iNumBins / (fMaxX - fMinX);
+  int iMaxCount = 0;
+  for (unsigned int i = 0; i < pData->iNumOrigPoints; ++i) {
+    if ((pValues[i] < fMinX) || (pValues[i] > fMaxX))
+      continue;
+    unsigned int iBin = (unsigned int)((pValues[i] - fMinX) * fBinScale);
+    if (iBin >= iNumBins)
+      iBin = iNumBins - 1;
+    if (++pData->pYData[iBin] > iMaxCount)
+      iMaxCount = pData->pYData[iBin];
+  }
+
+  // figure out Y-scale
+  float fMinY = (pData->fYMin != NOT_SET) ? pData->fYMin : 0;
+  float fMaxY = (pData->fYMax != NOT_SET) ? pData->fYMax : iMaxCount;
+  if (fMaxY <= fMinY)
+    fMaxY = fMinY + 1;
+  const float fYScale = (float)(bounds.size.h - (2 * pData->iMargin)) / (fMaxY - fMinY);
+  const float fXScale = (float)iPlotWidth / (fMaxX - fMinX);
+  const float fBinWidth = (fMaxX - fMinX) / iNumBins;
+  chart_layer_set_axes(pData, bounds, fMinX, fMaxX, fXScale, fBinWidth, fMinY, fMaxY, fYScale);
+
+  // calc bar positions
+  for (unsigned int i = 0; i < iNumBins; ++i) {
+    pData->pXData[i] = (int)(fXScale * fBinWidth * (i + 0.5f)) + pData->iMargin;
+    pData->pYData[i] = chart_layer_map_y(pData, bounds, pData->pYData[i]);
+  }
+
+  pData->iPointsToDraw = 0;
+}
+#endif
+
+#if PEBBLE_CHART_ENABLE_SERIES
+// lays out a bar for each series of each point, stacked or side by side
+// bars are cached as pixel y-values of both ends, in pYData and pYBaseData
+static void chart_layer_update_series_layout(ChartLayer* layer) {
+  ChartLayerData* pData = get_chart_data(layer);
+  const unsigned int iNumSeries = pData->iNumSeries;
+  const unsigned int iNumValues = pData->iNumOrigPoints * iNumSeries;
+  const bool bStacked = (pData->typePlot == eSTACKED_BAR);
+  const float* pValues = pData->pYOrigData;
+
+  // figure out sort order
+  ChartSortHelper* sort_order = (ChartSortHelper*) malloc(pData->iNumOrigPoints * sizeof(ChartSortHelper));
+  pData->pXData = (int*)malloc(pData->iNumOrigPoints * sizeof(int));
+  pData->pYData = (int*)malloc(iNumValues * sizeof(int));
+  pData->pYBaseData = (int*)malloc(iNumValues * sizeof(int));
+  if (!sort_order || !pData->pXData || !pData->pYData || !pData->pYBaseData) {
+    free(sort_order);
+    chart_layer_free_layout_cache(pData);
+    return;
+  }
+  for (unsigned int i = 0; i < pData->iNumOrigPoints; ++i)
+    sort_order[i] = ((ChartSortHelper) { .x_value = pData->pXOrigData[i], .index= i });
+  qsort(sort_order, pData->iNumOrigPoints, sizeof(ChartSortHelper), &cmpChartSortHelper);
+
+  // figure out Y-scale, from the ends of the stacks (which start from 0),
+  // or from the individual values like single bars
+  float fMinY = bStacked ? 0 : pValues[0];
+  float fMaxY = bStacked ? 0 : pValues[0];
+  for (unsigned int i = 0; i < iNumValues; i += iNumSeries) {
+    float fPositive = 0;
+    float fNegative = 0;
+    for (unsigned int k = 0; k < iNumSeries; ++k) {
+      const float value = pValues[i + k];
+      if (bStacked) {
+	if (value >= 0)
+	  fPositive += value;
+	else
+	  fNegative += value;
+      }
+      else {
+	if (value < fMinY)
+	  fMinY = value;
+	if (value > fMaxY)
+	  fMaxY = value;
+      }
+    }
+    if (bStacked && (fPositive > fMaxY))
+      fMaxY = fPositive;
+    if (bStacked && (fNegative < fMinY))
+      fMinY = fNegative;
+  }
+  if (pData->bAutoscale)
+    autoscale_axis(pData->fAutoscaleHeadroom, true, &fMinY, &fMaxY, &pData->fAutoYMin, &pData->fAutoYMax);
+  if (pData->fYMin != NOT_SET)
+    fMinY = pData->fYMin;
+  if (pData->fYMax != NOT_SET)
+    fMaxY = pData->fYMax;
+
+  // figure out X-scale
+  float fMinX = pData->pXOrigData[sort_order[0].index];
+  float fMaxX = pData->pXOrigData[sort_order[pData->iNumOrigPoints - 1].index];
+  float fMinXSep = (pData->iNumOrigPoints > 1) ? fMaxX - fMinX : 1;
+  for (unsigned int i = 1; i < pData->iNumOrigPoints; ++i) {
+    const float fSep = pData->pXOrigData[sort_order[i].index] - pData->pXOrigData[sort_order[i-1].index];
+    if (fSep < fMinXSep)
+      fMinXSep = fSep;
+  }
+  if (pData->fXMin != NOT_SET)
+    fMinX = pData->fXMin;
+  if (pData->fXMax != NOT_SET)
+    fMaxX = pData->fXMax;
+
+  GRect bounds = layer_get_bounds(chart_layer_get_layer(layer));
+  widen_empty_range(&fMinY, &fMaxY);
+  if (!fMinXSep)
+    widen_empty_range(&fMinX, &fMaxX);
+  const float fYScale = (float)(bounds.size.h - (2 * pData->iMargin)) / (fMaxY - fMinY);
+  const float fXScale = (float)(bounds.size.w - (2 * pData->iMargin)) / (fMaxX - fMinX + fMinXSep);
+  chart_layer_set_axes(pData, bounds, fMinX, fMaxX, fXScale, fMinXSep, fMinY, fMaxY, fYScale);
+
+  // bars which aren't stacked start from the x-axis, kept within the plot
+  int iBase = pData->iYAxisIntercept;
+  if (iBase > (bounds.size.h - pData->iMargin))
+    iBase = bounds.size.h - pData->iMargin;
+  if (iBase < pData->iMargin)
+    iBase = pData->iMargin;
+
+  // calc x values and bar ends
+  for (unsigned int j = 0; j < pData->iNumOrigPoints; ++j) {
+    const unsigned int iIndex = sort_order[j].index;
+    pData->pXData[j] = (int)(fXScale * (pData->pXOrigData[iIndex] - fMinX + fMinXSep/2)) + pData->iMargin;
+
+    float fPositive = 0;
+    float fNegative = 0;
+    for (unsigned int k = 0; k < iNumSeries; ++k) {
+      const float value = pValues[(iIndex * iNumSeries) + k];
+      if (bStacked) {
+	float* pStack = (value >= 0) ? &fPositive : &fNegative;
+	pData->pYBaseData[(j * iNumSeries) + k] = chart_layer_map_y(pData, bounds, *pStack);
+	*pStack += value;
+	pData->pYData[(j * iNumSeries) + k] = chart_layer_map_y(pData, bounds, *pStack);
+      }
+      else {
+	pData->pYBaseData[(j * iNumSeries) + k] = iBase;
+	pData->pYData[(j * iNumSeries) + k] = chart_layer_map_y(pData, bounds, value);
+      }
+    }
+  }
+  pData->iNumPoints = pData->iNumOrigPoints;
+  pData->iPointCapacity = pData->iNumPoints;
+  pData->iPointsToDraw = 0;
+  chart_layer_keep_sort_order(pData, sort_order);
+}
+#endif
+
+// binary search of x-sorted points
+// returns the index of the first point with an x-value
+// greater than x (if bAfter), or not less than x (otherwise)
+static unsigned int search_sorted_x(const ChartSortHelper* sort_order, const unsigned int iNumPoints,
+				    const float x, const bool bAfter) {
+  unsigned int iLow = 0;
+  unsigned int iHigh = iNumPoints;
+  while (iLow < iHigh) {
+    const unsigned int iMid = iLow + ((iHigh - iLow) / 2);
+    if ((sort_order[iMid].x_value < x) || (bAfter && (sort_order[iMid].x_value == x)))
+      iLow = iMid + 1;
+    else
+      iHigh = iMid;
+  }
+  return iLow;
+}
+
+#if PEBBLE_CHART_ENABLE_BUDGET && PEBBLE_CHART_ENABLE_OVERLAYS
+// caches the range of the aggregated buckets as the band overlay
+// each sampled point spans the buckets up to the next one
+static void chart_layer_map_bucket_band(ChartLayerData* pData, const GRect bounds, const ChartSortHelper* sort_order,
+					const unsigned int iFirst, const unsigned int iEnd, const unsigned int iSampling) {
+  pData->pBandMinData = (int*)malloc(pData->iNumPoints * sizeof(int));
+  pData->pBandMaxData = (int*)malloc(pData->iNumPoints * sizeof(int));
+  if (!pData->pBandMinData || !pData->pBandMaxData) {
+    free(pData->pBandMinData);
+    free(pData->pBandMaxData);
+    pData->pBandMinData = NULL;
+    pData->pBandMaxData = NULL;
+    return;
+  }
+
+  for (unsigned int j = 0; j < pData->iNumPoints; ++j) {
+    const unsigned int iStart = iFirst + j * iSampling;
+    float fMin = pData->pYMinOrigData[sort_order[iStart].index];
+    float fMax = pData->pYMaxOrigData[sort_order[iStart].index];
+    for (unsigned int i = iStart + 1; (i < iStart + iSampling) && (i < iEnd); ++i) {
+      const unsigned int k = sort_order[i].index;
+      if (pData->pYMinOrigData[k] < fMin)
+	fMin = pData->pYMinOrigData[k];
+      if (pData->pYMaxOrigData[k] > fMax)
+	fMax = pData->pYMaxOrigData[k];
+    }
+    pData->pBandMinData[j] = chart_layer_map_y(pData, bounds, fMin);
+    pData->pBandMaxData[j] = chart_layer_map_y(pData, bounds, fMax);
+  }
+}
+#endif
+
+// lays out line and bar plots, from the points sorted by x-value
+// points outside of the x-axis range are culled
+static void chart_layer_update_sorted_layout(ChartLayer* layer) {
+  ChartLayerData* pData = get_chart_data(layer);
+
+  // figure out sort order
+  ChartSortHelper* sort_order = (ChartSortHelper*) malloc(pData->iNumOrigPoints * sizeof(ChartSortHelper));
+  if (!sort_order)
+    return;
+  for (unsigned int i = 0; i < pData->iNumOrigPoints; ++i)
+    sort_order[i] = ((ChartSortHelper) { .x_value = pData->pXOrigData[i], .index= i });
+  qsort(sort_order, pData->iNumOrigPoints, sizeof(ChartSortHelper), &cmpChartSortHelper);
+
+  // cull points outside of the x-axis range, keeping the neighbours
+  // just outside of it so that lines run to the edge of the plot
+  unsigned int iFirst = 0;
+  unsigned int iEnd = pData->iNumOrigPoints;
+  if (pData->fXMin != NOT_SET) {
+    iFirst = search_sorted_x(sort_order, pData->iNumOrigPoints, pData->fXMin, false);
+    if (iFirst)
+      --iFirst;
+  }
+  if (pData->fXMax != NOT_SET) {
+    iEnd = search_sorted_x(sort_order, pData->iNumOrigPoints, pData->fXMax, true);
+    if (iEnd < pData->iNumOrigPoints)
+      ++iEnd;
+  }
+  if (iEnd <= iFirst)
+    iFirst = iEnd - 1;
+  const unsigned int iNumVisible = iEnd - iFirst;
+
+  // figure out sampling rate
+  GRect bounds = layer_get_bounds(chart_layer_get_layer(layer));
+  const unsigned int iPlotWidth = (unsigned int)bounds.size.w - (2 * pData->iMargin);
+  const unsigned int iSampling = (iPlotWidth > iNumVisible) ? 1 : iNumVisible / iPlotWidth;
+
+  // init for cached data
+  pData->iNumPoints = (iNumVisible + iSampling - 1) / iSampling;
+  pData->iPointCapacity = pData->iNumPoints;
+  pData->pXData = (int*)malloc(pData->iNumPoints * sizeof(int));
+  pData->pYData = (int*)malloc(pData->iNumPoints * sizeof(int));
+  if (!pData->pXData || !pData->pYData) {
+    free(sort_order);
+    chart_layer_free_layout_cache(pData);
+    return;
+  }
+
+  // figure out Y-scale
+  float fMaxY = pData->pYOrigData[sort_order[iFirst].index];
+  float fMinY = fMaxY;
+  for (unsigned int i = iFirst; i < iEnd; i += iSampling) {
+    const float y = pData->pYOrigData[sort_order[i].index];
+    if (y > fMaxY)
+      fMaxY = y;
+    if (y < fMinY)
+      fMinY = y;
+  }
+#if PEBBLE_CHART_ENABLE_BUDGET
+  // aggregated data also shows the range of each bucket
+  if (pData->pYMinOrigData) {
+    for (unsigned int i = iFirst; i < iEnd; ++i) {
+      const unsigned int k = sort_order[i].index;
+      if (pData->pYMaxOrigData[k] > fMaxY)
+	fMaxY = pData->pYMaxOrigData[k];
+      if (pData->pYMinOrigData[k] < fMinY)
+	fMinY = pData->pYMinOrigData[k];
+    }
+  }
+#endif
+  if (pData->bAutoscale)
+    autoscale_axis(pData->fAutoscaleHeadroom, true, &fMinY, &fMaxY, &pData->fAutoYMin, &pData->fAutoYMax);
+  if (pData->fYMin != NOT_SET)
+    fMinY = pData->fYMin;
+  if (pData->fYMax != NOT_SET)
+    fMaxY = pData->fYMax;
+  widen_empty_range(&fMinY, &fMaxY);
+  const float fYScale = (float)(bounds.size.h - (2 * pData->iMargin)) / (fMaxY - fMinY); 
+
+  // figure out X-scale, bars also need the smallest x spacing
+  float fMinX = (pData->fXMin != NOT_SET) ? pData->fXMin : sort_order[iFirst].x_value;
+  float fMaxX = (pData->fXMax != NOT_SET) ? pData->fXMax : sort_order[iEnd - 1].x_value;
+  float fMinXSep = 0;
+  if ((pData->typePlot == eBAR) && (iNumVisible > 1)) {
+    fMinXSep = sort_order[iFirst + 1].x_value - sort_order[iFirst].x_value;
+    for (unsigned int i = iFirst + 2; i < iEnd; ++i) {
+      if ((sort_order[i].x_value - sort_order[i-1].x_value) < fMinXSep)
+	fMinXSep = sort_order[i].x_value - sort_order[i-1].x_value;
+    }
+  }
+  if (!fMinXSep)
+    widen_empty_range(&fMinX, &fMaxX);
+  const float fXScale = (float)iPlotWidth / (fMaxX - fMinX + fMinXSep); 
+
+  chart_layer_set_axes(pData, bounds, fMinX, fMaxX, fXScale, fMinXSep, fMinY, fMaxY, fYScale);
+
+  // calc x and y values
+  for (unsigned int i = iFirst, j = 0; j < pData->iNumPoints; i += iSampling, ++j) {
+    pData->pXData[j] = (int)(fXScale * (sort_order[i].x_value - fMinX + fMinXSep/2)) + pData->iMargin;
+    pData->pYData[j] = chart_layer_map_y(pData, bounds, pData->pYOrigData[sort_order[i].index]);
+  }
+
+  // calc overlays, from all the points rather than just the visible, sampled ones
+  chart_layer_alloc_overlay_cache(pData, pData->iNumPoints);
+  if (chart_layer_has_overlays(pData)) {
+    for (unsigned int i = 0, j = 0; (i < iEnd) && (j < pData->iNumPoints); ++i) {
+      chart_layer_push_overlays(pData, pData->pYOrigData[sort_order[i].index]);
+      if ((i >= iFirst) && !((i - iFirst) % iSampling))
+	chart_layer_map_overlays(pData, bounds, j++);
+    }
+  }
+#if PEBBLE_CHART_ENABLE_BUDGET && PEBBLE_CHART_ENABLE_OVERLAYS
+  if (pData->pYMinOrigData && !pData->pBandMinData)
+    chart_layer_map_bucket_band(pData, bounds, sort_order, iFirst, iEnd, iSampling);
+#endif
+
+  pData->iPointsToDraw = 0;
+  chart_layer_keep_sort_order(pData, sort_order);
+}
+
+#if PEBBLE_CHART_ENABLE_SCATTER
+// lays out scatter plots, which are drawn in any order so need no sorting
+// points outside of the axes ranges are culled
+static void chart_layer_update_scatter_layout(ChartLayer* layer) {
+  ChartLayerData* pData = get_chart_data(layer);
+  const float* pXValues = pData->pXOrigData;
+  const float* pYValues = pData->pYOrigData;
+
+  // init for cached data
+  pData->pXData = (int*)malloc(pData->iNumOrigPoints * sizeof(int));
+  pData->pYData = (int*)malloc(pData->iNumOrigPoints * sizeof(int));
+  if (!pData->pXData || !pData->pYData) {
+    chart_layer_free_layout_cache(pData);
+    return;
+  }
+  pData->iPointCapacity = pData->iNumOrigPoints;
+
+  // figure out X and Y ranges
+  float fMinX = pXValues[0];
+  float fMaxX = pXValues[0];
+  float fMinY = pYValues[0];
+  float fMaxY = pYValues[0];
+  for (unsigned int i = 1; i < pData->iNumOrigPoints; ++i) {
+    if (pXValues[i] < fMinX)
+      fMinX = pXValues[i];
+    if (pXValues[i] > fMaxX)
+      fMaxX = pXValues[i];
+    if (pYValues[i] < fMinY)
+      fMinY = pYValues[i];
+    if (pYValues[i] > fMaxY)
+      fMaxY = pYValues[i];
+  }
+  if (pData->bAutoscale)
+    autoscale_axis(pData->fAutoscaleHeadroom, true, &fMinY, &fMaxY, &pData->fAutoYMin, &pData->fAutoYMax);
+  if (pData->fXMin != NOT_SET)
+    fMinX = pData->fXMin;
+  if (pData->fXMax != NOT_SET)
+    fMaxX = pData->fXMax;
+  if (pData->fYMin != NOT_SET)
+    fMinY = pData->fYMin;
+  if (pData->fYMax != NOT_SET)
+    fMaxY = pData->fYMax;
+
+  GRect bounds = layer_get_bounds(chart_layer_get_layer(layer));
+  widen_empty_range(&fMinX, &fMaxX);
+  widen_empty_range(&fMinY, &fMaxY);
+  const float fYScale = (float)(bounds.size.h - (2 * pData->iMargin)) / (fMaxY - fMinY);
+  const float fXScale = (float)(bounds.size.w - (2 * pData->iMargin)) / (fMaxX - fMinX);
+  chart_layer_set_axes(pData, bounds, fMinX, fMaxX, fXScale, 0, fMinY, fMaxY, fYScale);
+
+  // calc x and y values
+  unsigned int j = 0;
+  for (unsigned int i = 0; i < pData->iNumOrigPoints; ++i) {
+    if ((pXValues[i] < fMinX) || (pXValues[i] > fMaxX) || (pYValues[i] < fMinY) || (pYValues[i] > fMaxY))
+      continue;
+    pData->pXData[j] = (int)(fXScale * (pXValues[i] - fMinX)) + pData->iMargin;
+    pData->pYData[j] = chart_layer_map_y(pData, bounds, pYValues[i]);
+    ++j;
+  }
+  pData->iNumPoints = j;
+  pData->iPointsToDraw = 0;
+}
+#endif
+
+// lays out the chart with the routine of its plot type
+// bWasDrawn is set if the previous layout was completely drawn
+static void chart_layer_layout_plot(ChartLayer* layer, const bool bWasDrawn) {
+  ChartLayerData* pData = get_chart_data(layer);
+
+#if PEBBLE_CHART_ENABLE_HISTORY
+  if (pData->history.pBlocks) {
+    chart_layer_update_history_layout(layer, bWasDrawn);
+    return;
+  }
+#else
+  (void)bWasDrawn;
+#endif
+
+  if (!pData->pYOrigData || !pData->iNumOrigPoints)
+    return;
+
+  // other than histograms and series bars, plot types only show single series data
+  const bool bHasXY = pData->pXOrigData && (pData->iNumSeries == 1);
+  switch (pData->typePlot) {
+  case eLINE:
+  case eBAR:
+    if (bHasXY)
+      chart_layer_update_sorted_layout(layer);
+    break;
+#if PEBBLE_CHART_ENABLE_SCATTER
+  case eSCATTER:
+    if (bHasXY)
+      chart_layer_update_scatter_layout(layer);
+    break;
+#endif
+#if PEBBLE_CHART_ENABLE_HISTOGRAM
+  case eHISTOGRAM:
+    chart_layer_update_histogram_layout(layer);
+    break;
+#endif
+#if PEBBLE_CHART_ENABLE_SERIES
+  case eSTACKED_BAR:
+  case eGROUPED_BAR:
+    if (pData->pXOrigData)
+      chart_layer_update_series_layout(layer);
+    break;
+#endif
+  default:
+    break;
+  }
+}
+
+// if needed, prepares data for drawing
+// this is where the heavy lifting is done,
+// by the layout routine of the plot type
+static void chart_layer_update_layout(ChartLayer* layer) {
+  if (layer) {
+    
+    // if nothing to do, return
+    ChartLayerData* pData = get_chart_data(layer);
+    if (!pData->bLayoutDirty)
+      return;
+    pData->bLayoutDirty = false;
+
+    // clear out previously cached values
+    const bool bWasDrawn = pData->iPointsToDraw && (pData->iPointsToDraw == pData->iNumPoints);
+#if PEBBLE_CHART_ENABLE_ANIMATION
+    // a completely drawn chart can morph from its previous shape,
+    // so keep its pixel positions until the new layout is done
+    int* pOldXData = NULL;
+    int* pOldYData = NULL;
+    const unsigned int iNumOldPoints = pData->iNumPoints;
+    if (pData->bMorph && pData->bAnimate && bWasDrawn && !chart_layer_has_bar_bases(pData)) {
+      pOldXData = pData->pXData;
+      pOldYData = pData->pYData;
+      pData->pXData = NULL;
+      pData->pYData = NULL;
+    }
+#endif
+    chart_layer_free_layout_cache(pData);
+
+    chart_layer_layout_plot(layer, bWasDrawn);
+
+#if PEBBLE_CHART_ENABLE_ANIMATION
+    if (pOldYData) {
+      chart_layer_start_morph(pData, pOldXData, pOldYData, iNumOldPoints);
+      free(pOldXData);
+      free(pOldYData);
+    }
+#endif
+  }
+}
+
+#if PEBBLE_CHART_ENABLE_ANIMATION
+static void animation_started(Animation *animation, void *data) {
+}
+
+static void animation_stopped(Animation *animation, bool finished, void *l) {
+}
+
+// sets the number of points to draw proportionally to the animation progress,
+// or moves the points of a morph
+// returns true if the chart changed
+static bool chart_layer_set_animation_progress(ChartLayerData* data, const uint32_t time_normalized) {
+  if (data->pMorphData)
+    return chart_layer_morph_to(data, time_normalized);
+
+  unsigned int iPointsToDraw = data->iNumPoints;
+  if (time_normalized < ANIMATION_NORMALIZED_MAX)
+    iPointsToDraw = (int) (data->iNumPoints * ((float)time_normalized/(float)ANIMATION_NORMALIZED_MAX));
+
+  if (iPointsToDraw == data->iPointsToDraw)
+    return false;
+  data->iPointsToDraw = iPointsToDraw;
+  return true;
+}
+
+// called for each frame of the animation
+static void animation_update(Animation* animation, const uint32_t time_normalized) {
+  ChartLayer* layer = (ChartLayer*) animation_get_context(animation);
+
+  // trigger re-draw
+  if (chart_layer_set_animation_progress(get_chart_data(layer), time_normalized))
+    layer_mark_dirty(chart_layer_get_layer(layer));
+}
+
+static const AnimationImplementation chart_animation_impl = { .update = animation_update };
+
+// gets the chart's own animation, creating it on first use
+static Animation* chart_layer_get_animation(ChartLayer* layer) {
+  ChartLayerData* data = get_chart_data(layer);
+  if (!data->pAnimation) {
+    data->pAnimation = animation_create();
+    if (!data->pAnimation)
+      return NULL;
+
+    animation_set_curve(data->pAnimation, AnimationCurveLinear);
+    animation_set_handlers(data->pAnimation, 
+			   ((AnimationHandlers) {
+			     .started = (AnimationStartedHandler)animation_started,
+			       .stopped = (AnimationStoppedHandler)animation_stopped
+			       }), layer);
+    animation_set_implementation(data->pAnimation, &chart_animation_impl);
+  }
+  return data->pAnimation;
+}
+
+///////////////////////////////////
+// shared animator
+
+struct ChartAnimator {
+  Animation* pAnimation;
+  Layer* pRoot;
+  ChartLayer* pCharts; // registered charts, linked through pNextAnimated
+  uint32_t iEnd; // in ms, when the last started chart animation ends
+};
+
+// current time in ms, wrapping around
+static uint32_t current_time_ms(void) {
+  time_t seconds;
+  uint16_t ms;
+  time_ms(&seconds, &ms);
+  return (uint32_t)seconds * 1000 + ms;
+}
+
+// advances every animating chart by the time elapsed since it started,
+// then redraws them all at once
+static void chart_animator_update(Animation* animation, const uint32_t time_normalized) {
+  ChartAnimator* pAnimator = (ChartAnimator*) animation_get_context(animation);
+  const uint32_t iNow = current_time_ms();
+
+  bool bChanged = false;
+  for (ChartLayer* layer = pAnimator->pCharts; layer; layer = get_chart_data(layer)->pNextAnimated) {
+    ChartLayerData* data = get_chart_data(layer);
+    if (!data->bAnimating)
+      continue;
+
+    // the last frame finishes every chart, whatever the clock says
+    const uint32_t iElapsed = iNow - data->iAnimationStart;
+    uint32_t iProgress = ANIMATION_NORMALIZED_MAX;
+    if ((time_normalized < ANIMATION_NORMALIZED_MAX) && (iElapsed < data->iAnimationDuration))
+      iProgress = (uint32_t) (ANIMATION_NORMALIZED_MAX * ((float)iElapsed/(float)data->iAnimationDuration));
+    else
+      data->bAnimating = false;
+
+    if (chart_layer_set_animation_progress(data, iProgress))
+      bChanged = true;
+  }
+
+  // trigger a single re-draw for all the charts
+  if (bChanged)
+    layer_mark_dirty(pAnimator->pRoot);
+}
+
+static const AnimationImplementation chart_animator_impl = { .update = chart_animator_update };
+
+// starts animating the chart on the shared animation,
+// which is rescheduled if it would end before the chart's animation
+static void chart_animator_start(ChartAnimator* pAnimator, ChartLayer* layer) {
+  ChartLayerData* data = get_chart_data(layer);
+  const uint32_t iNow = current_time_ms();
+  data->iAnimationStart = iNow;
+  data->bAnimating = true;
+
+  const uint32_t iEnd = iNow + data->iAnimationDuration;
+  if (!animation_is_scheduled(pAnimator->pAnimation) || ((int32_t)(iEnd - pAnimator->iEnd) > 0)) {
+    animation_unschedule(pAnimator->pAnimation);
+    pAnimator->iEnd = iEnd;
+    animation_set_duration(pAnimator->pAnimation, data->iAnimationDuration);
+    animation_schedule(pAnimator->pAnimation);
+  }
+}
+
+// unregisters the chart from its animator, if any
+static void chart_animator_remove(ChartLayer* layer) {
+  ChartLayerData* data = get_chart_data(layer);
+  if (!data->pAnimator)
+    return;
+
+  for (ChartLayer** ppLayer = &data->pAnimator->pCharts; *ppLayer; ppLayer = &get_chart_data(*ppLayer)->pNextAnimated) {
+    if (*ppLayer == layer) {
+      *ppLayer = data->pNextAnimated;
+      break;
+    }
+  }
+  data->pAnimator = NULL;
+  data->pNextAnimated = NULL;
+  data->bAnimating = false;
+}
+
+ChartAnimator* chart_animator_create(Layer* root) {
+  ChartAnimator* pAnimator = (ChartAnimator*) malloc(sizeof(ChartAnimator));
+  if (!pAnimator)
+    return NULL;
+
+  pAnimator->pAnimation = animation_create();
+  if (!pAnimator->pAnimation) {
+    free(pAnimator);
+    return NULL;
+  }
+  pAnimator->pRoot = root;
+  pAnimator->pCharts = NULL;
+  pAnimator->iEnd = 0;
+
+  animation_set_curve(pAnimator->pAnimation, AnimationCurveLinear);
+  animation_set_handlers(pAnimator->pAnimation, ((AnimationHandlers) { .started = NULL, .stopped = NULL }), pAnimator);
+  animation_set_implementation(pAnimator->pAnimation, &chart_animator_impl);
+
+  return pAnimator;
+}
+
+void chart_animator_destroy(ChartAnimator* animator) {
+  if (!animator)
+    return;
+
+  // charts in the middle of animating start over with their own animation
+  while (animator->pCharts) {
+    ChartLayer* layer = animator->pCharts;
+    const bool bWasAnimating = get_chart_data(layer)->bAnimating;
+    chart_animator_remove(layer);
+    if (bWasAnimating)
+      layer_mark_dirty(chart_layer_get_layer(layer));
+  }
+
+  animation_destroy(animator->pAnimation);
+  free(animator);
+}
+
+void chart_layer_set_animator(ChartLayer* layer, ChartAnimator* animator) {
+  if (!layer)
+    return;
+
+  ChartLayerData* data = get_chart_data(layer);
+  if (data->pAnimator == animator)
+    return;
+  chart_animator_remove(layer);
+
+  if (animator) {
+    // the chart's own animation isn't needed any more
+    if (data->pAnimation) {
+      animation_destroy(data->pAnimation);
+      data->pAnimation = NULL;
+    }
+    data->pAnimator = animator;
+    data->pNextAnimated = animator->pCharts;
+    animator->pCharts = layer;
+  }
+
+  // an unfinished animation starts over on the next draw
+  layer_mark_dirty(chart_layer_get_layer(layer));
+}
+
+// stops the chart's running animation, so that it can be started over
+static void chart_layer_stop_animation(ChartLayerData* data) {
+  if (data->pAnimator)
+    data->bAnimating = false;
+  else if (data->pAnimation)
+    animation_unschedule(data->pAnimation);
+}
+
+// returns true if the chart's animation is running
+static bool chart_layer_is_animating(ChartLayerData* data) {
+  if (data->pAnimator)
+    return data->bAnimating;
+  return data->pAnimation && animation_is_scheduled(data->pAnimation);
+}
+
+// starts the chart's animation, returns false if there is no animation to start
+static bool chart_layer_start_animation(ChartLayer* layer) {
+  ChartLayerData* data = get_chart_data(layer);
+  if (data->pAnimator) {
+    chart_animator_start(data->pAnimator, layer);
+    return true;
+  }
+
+  Animation* pAnimation = chart_layer_get_animation(layer);
+  if (!pAnimation)
+    return false;
+
+  // do this here since duration is configurable
+  animation_set_duration(pAnimation, data->iAnimationDuration);
+  // kick off animation
+  animation_schedule(pAnimation);
+  return true;
+}
+
+///////////////////////////////////
+// morphing
+
+// clamps a pixel value to the range of int16_t
+static int16_t clamp_int16(const int value) {
+  if (value > INT16_MAX)
+    return INT16_MAX;
+  if (value < INT16_MIN)
+    return INT16_MIN;
+  return (int16_t)value;
+}
+
+// prepares morphing from the previous pixel y-values to those of the new layout
+// each new point starts from the old point with the same index or, if the number
+// of points changed, from the old line at the same pixel column (for scatter plots,
+// from the old point at the same relative index)
+static void chart_layer_start_morph(ChartLayerData* pData, const int* pOldX, const int* pOldY, const unsigned int iNumOld) {
+  const unsigned int iNumPoints = pData->iNumPoints;
+  if (!iNumPoints || !iNumOld || chart_layer_has_bar_bases(pData))
+    return;
+
+  int16_t* pMorphData = (int16_t*)malloc(2 * iNumPoints * sizeof(int16_t));
+  if (!pMorphData)
+    return;
+  int16_t* pTarget = pMorphData;
+  int16_t* pOffset = pMorphData + iNumPoints;
+
+  // old and new points are both in x-order, so the old segment
+  // containing the new point's column only ever moves right
+  bool bMoved = false;
+  unsigned int j = 0;
+  for (unsigned int i = 0; i < iNumPoints; ++i) {
+    int iOldY;
+    if (iNumOld == iNumPoints)
+      iOldY = pOldY[i];
+    else if (pData->typePlot == eSCATTER)
+      iOldY = pOldY[i * iNumOld / iNumPoints];
+    else {
+      const int x = pData->pXData[i];
+      while (((j + 1) < iNumOld) && (pOldX[j + 1] <= x))
+	++j;
+      iOldY = pOldY[j];
+      if (((j + 1) < iNumOld) && (pOldX[j] < x))
+	iOldY += (pOldY[j + 1] - pOldY[j]) * (x - pOldX[j]) / (pOldX[j + 1] - pOldX[j]);
+    }
+
+    pTarget[i] = clamp_int16(pData->pYData[i]);
+    pOffset[i] = clamp_int16(iOldY - pTarget[i]);
+    if (pOffset[i])
+      bMoved = true;
+  }
+
+  if (!bMoved) {
+    free(pMorphData);
+    return;
+  }
+
+  // the morph replaces the drawing animation, and starts over if one was running
+  pData->pMorphData = pMorphData;
+  pData->iNumMorphPoints = iNumPoints;
+  pData->iMorphRemaining = 0;
+  pData->iPointsToDraw = iNumPoints;
+  chart_layer_morph_to(pData, 0);
+  chart_layer_stop_animation(pData);
+}
+
+// moves the points time_normalized of the way from their start to the new layout
+// a single multiply and shift per point, without redoing the layout
+// returns true if the points moved
+static bool chart_layer_morph_to(ChartLayerData* pData, const uint32_t time_normalized) {
+  const int32_t iRemaining = (int32_t)((((uint32_t)ANIMATION_NORMALIZED_MAX - time_normalized) << 16) / ANIMATION_NORMALIZED_MAX);
+  if (iRemaining == pData->iMorphRemaining)
+    return false;
+  pData->iMorphRemaining = iRemaining;
+
+  const int16_t* pTarget = pData->pMorphData;
+  const int16_t* pOffset = pData->pMorphData + pData->iNumMorphPoints;
+  for (unsigned int i = 0; i < pData->iNumMorphPoints; ++i)
+    pData->pYData[i] = pTarget[i] + ((pOffset[i] * iRemaining + 0x8000) >> 16);
+
+  // done, the points are at their new positions
+  if (!iRemaining) {
+    free(pData->pMorphData);
+    pData->pMorphData = NULL;
+    pData->iNumMorphPoints = 0;
+  }
+  return true;
+}
+#endif
+
+///////////////////////////////////
+// drawing
+
+// where a chart is drawn: through the graphics context of a layer update,
+// or straight into the pixels of a bitmap (see chart_layer_render_to_bitmap)
+typedef struct {
+  GContext* ctx;
+#if PEBBLE_CHART_ENABLE_RENDER
+  uint8_t* pPixels; // NULL when drawing through ctx
+  uint16_t iRowBytes;
+  GBitmapFormat format;
+  GRect frame; // bounds of the bitmap, the chart is drawn at its origin
+  GColor clrFill;
+  GColor clrStroke;
+#endif
+} ChartSurface;
+
+#if PEBBLE_CHART_ENABLE_RENDER
+// sets the pixels from x0 to x1 (inclusive) of row y to color
+// clipped to the bitmap, clear colors leave the pixels as they are
+static void surface_draw_span(ChartSurface* pSurface, int x0, int x1, const int y, const GColor color) {
+  if (!(color.argb & 0xC0) || (y < 0) || (y >= pSurface->frame.size.h))
+    return;
+  if (x0 > x1) {
+    const int x = x0;
+    x0 = x1;
+    x1 = x;
+  }
+  if (x0 < 0)
+    x0 = 0;
+  if (x1 >= pSurface->frame.size.w)
+    x1 = pSurface->frame.size.w - 1;
+
+  uint8_t* pRow = pSurface->pPixels + ((pSurface->frame.origin.y + y) * pSurface->iRowBytes);
+  x0 += pSurface->frame.origin.x;
+  x1 += pSurface->frame.origin.x;
+  if (pSurface->format == GBitmapFormat8Bit) {
+    for (int x = x0; x <= x1; ++x)
+      pRow[x] = color.argb;
+  }
+  else {
+    // 1-bit pixels are white for the lighter half of the colors
+    const bool bWhite = (((color.argb >> 4) & 0x3) + ((color.argb >> 2) & 0x3) + (color.argb & 0x3)) > 4;
+    for (int x = x0; x <= x1; ++x) {
+      if (bWhite)
+	pRow[x >> 3] |= (uint8_t)(1 << (x & 7));
+      else
+	pRow[x >> 3] &= (uint8_t)~(1 << (x & 7));
+    }
+  }
+}
+#endif
+
+static void surface_set_fill_color(ChartSurface* pSurface, const GColor color) {
+#if PEBBLE_CHART_ENABLE_RENDER
+  if (pSurface->pPixels) {
+    pSurface->clrFill = color;
+    return;
+  }
+#endif
+  graphics_context_set_fill_color(pSurface->ctx, color);
+}
+
+static void surface_set_stroke_color(ChartSurface* pSurface, const GColor color) {
+#if PEBBLE_CHART_ENABLE_RENDER
+  if (pSurface->pPixels) {
+    pSurface->clrStroke = color;
+    return;
+  }
+#endif
+  graphics_context_set_stroke_color(pSurface->ctx, color);
+}
+
+static void surface_fill_rect(ChartSurface* pSurface, const GRect rect) {
+#if PEBBLE_CHART_ENABLE_RENDER
+  if (pSurface->pPixels) {
+    for (int y = rect.origin.y; y < (rect.origin.y + rect.size.h); ++y)
+      surface_draw_span(pSurface, rect.origin.x, rect.origin.x + rect.size.w - 1, y, pSurface->clrFill);
+    return;
+  }
+#endif
+  graphics_fill_rect(pSurface->ctx, rect, 0, GCornerNone);
+}
+
+static void surface_draw_rect(ChartSurface* pSurface, const GRect rect) {
+#if PEBBLE_CHART_ENABLE_RENDER
+  if (pSurface->pPixels) {
+    const int iRight = rect.origin.x + rect.size.w - 1;
+    const int iBottom = rect.origin.y + rect.size.h - 1;
+    surface_draw_span(pSurface, rect.origin.x, iRight, rect.origin.y, pSurface->clrStroke);
+    surface_draw_span(pSurface, rect.origin.x, iRight, iBottom, pSurface->clrStroke);
+    for (int y = rect.origin.y + 1; y < iBottom; ++y) {
+      surface_draw_span(pSurface, rect.origin.x, rect.origin.x, y, pSurface->clrStroke);
+      surface_draw_span(pSurface, iRight, iRight, y, pSurface->clrStroke);
+    }
+    return;
+  }
+#endif
+  graphics_draw_rect(pSurface->ctx, rect);
+}
+
+// draws the line from p0 to p1, both ends included
+static void surface_draw_line(ChartSurface* pSurface, const GPoint p0, const GPoint p1) {
+#if PEBBLE_CHART_ENABLE_RENDER
+  if (pSurface->pPixels) {
+    // Bresenham, one pixel per step along the longer axis
+    int x = p0.x;
+    int y = p0.y;
+    const int dx = abs(p1.x - p0.x);
+    const int dy = -abs(p1.y - p0.y);
+    const int sx = (p0.x < p1.x) ? 1 : -1;
+    const int sy = (p0.y < p1.y) ? 1 : -1;
+    int iError = dx + dy;
+    for (;;) {
+      surface_draw_span(pSurface, x, x, y, pSurface->clrStroke);
+      if ((x == p1.x) && (y == p1.y))
+	break;
+      const int iError2 = 2 * iError;
+      if (iError2 >= dy) {
+	iError += dy;
+	x += sx;
+      }
+      if (iError2 <= dx) {
+	iError += dx;
+	y += sy;
+      }
+    }
+    return;
+  }
+#endif
+  graphics_draw_line(pSurface->ctx, p0, p1);
+}
+
+static void surface_fill_circle(ChartSurface* pSurface, const GPoint center, const uint16_t iRadius) {
+#if PEBBLE_CHART_ENABLE_RENDER
+  if (pSurface->pPixels) {
+    // one span per row, as wide as the circle at the row's distance from the center
+    const int r = iRadius;
+    int iHalfWidth = r;
+    for (int dy = 0; dy <= r; ++dy) {
+      while ((iHalfWidth > 0) && (((iHalfWidth * iHalfWidth) + (dy * dy)) > ((r * r) + r)))
+	--iHalfWidth;
+      surface_draw_span(pSurface, center.x - iHalfWidth, center.x + iHalfWidth, center.y + dy, pSurface->clrFill);
+      if (dy)
+	surface_draw_span(pSurface, center.x - iHalfWidth, center.x + iHalfWidth, center.y - dy, pSurface->clrFill);
+    }
+    return;
+  }
+#endif
+  graphics_fill_circle(pSurface->ctx, center, iRadius);
+}
+
+// outcodes for line clipping
+#define CLIP_LEFT   0x1
+#define CLIP_RIGHT  0x2
+#define CLIP_TOP    0x4
+#define CLIP_BOTTOM 0x8
+
+static int clip_outcode(const int x, const int y, const GRect clip) {
+  int code = 0;
+  if (x < clip.origin.x)
+    code |= CLIP_LEFT;
+  else if (x > (clip.origin.x + clip.size.w))
+    code |= CLIP_RIGHT;
+  if (y < clip.origin.y)
+    code |= CLIP_TOP;
+  else if (y > (clip.origin.y + clip.size.h))
+    code |= CLIP_BOTTOM;
+  return code;
+}
+
+// draws the part of the line from (x0, y0) to (x1, y1) within clip
+// (Cohen-Sutherland, in integer arithmetic)
+static void draw_clipped_line(ChartSurface* pSurface, int x0, int y0, int x1, int y1, const GRect clip) {
+  int code0 = clip_outcode(x0, y0, clip);
+  int code1 = clip_outcode(x1, y1, clip);
+  while (code0 | code1) {
+    // both ends on the same outside of the clip
+    if (code0 & code1)
+      return;
+
+    // move the end which is outside to the edge it crosses
+    const int code = code0 ? code0 : code1;
+    int x, y;
+    if (code & CLIP_TOP) {
+      y = clip.origin.y;
+      x = x0 + (int)((int64_t)(x1 - x0) * (y - y0) / (y1 - y0));
+    }
+    else if (code & CLIP_BOTTOM) {
+      y = clip.origin.y + clip.size.h;
+      x = x0 + (int)((int64_t)(x1 - x0) * (y - y0) / (y1 - y0));
+    }
+    else if (code & CLIP_RIGHT) {
+      x = clip.origin.x + clip.size.w;
+      y = y0 + (int)((int64_t)(y1 - y0) * (x - x0) / (x1 - x0));
+    }
+    else {
+      x = clip.origin.x;
+      y = y0 + (int)((int64_t)(y1 - y0) * (x - x0) / (x1 - x0));
+    }
+    if (code == code0) {
+      x0 = x;
+      y0 = y;
+      code0 = clip_outcode(x0, y0, clip);
+    }
+    else {
+      x1 = x;
+      y1 = y;
+      code1 = clip_outcode(x1, y1, clip);
+    }
+  }
+  surface_draw_line(pSurface, ((GPoint) { .x = x0, .y = y0 }), ((GPoint) { .x = x1, .y = y1 }));
+}
+
+#if PEBBLE_CHART_ENABLE_BAR || PEBBLE_CHART_ENABLE_HISTOGRAM || PEBBLE_CHART_ENABLE_SERIES
+// fills the part of the rectangle at (x, y) of size (w, h) within clip
+// negative sizes extend the rectangle left or up from (x, y)
+static void fill_clipped_rect(ChartSurface* pSurface, int x, int y, int w, int h, const GRect clip) {
+  if (w < 0) {
+    x += w;
+    w = -w;
+  }
+  if (h < 0) {
+    y += h;
+    h = -h;
+  }
+  const int iRight = ((x + w) < (clip.origin.x + clip.size.w)) ? (x + w) : (clip.origin.x + clip.size.w);
+  const int iBottom = ((y + h) < (clip.origin.y + clip.size.h)) ? (y + h) : (clip.origin.y + clip.size.h);
+  if (x < clip.origin.x)
+    x = clip.origin.x;
+  if (y < clip.origin.y)
+    y = clip.origin.y;
+  if ((iRight <= x) || (iBottom <= y))
+    return;
+  surface_fill_rect(pSurface,
+		    ((GRect) {
+		      .origin = { x, y },
+			.size = { iRight - x, iBottom - y } }));
+}
+#endif
+
+// draws the segments between the points of line plots, and the points if shown
+static void chart_layer_draw_line(ChartSurface* pSurface, const ChartLayerData* data, const GRect bounds, const GRect plot) {
+  for (unsigned int i = 0; (i < data->iPointsToDraw) && ((i + 1) < data->iNumPoints); ++i)
+    draw_clipped_line(pSurface, data->pXData[i], data->pYData[i], data->pXData[i+1], data->pYData[i+1], plot);
+
+  if (data->bShowPoints && (data->iNumOrigPoints < ((unsigned int)bounds.size.w / 3))) {
+    for (unsigned int i = 0; i < data->iPointsToDraw; ++i) {
+      if (!clip_outcode(data->pXData[i], data->pYData[i], plot))
+	surface_fill_circle(pSurface, ((GPoint) { .x = data->pXData[i], .y = data->pYData[i] }), 3);
+    }
+  }
+}
+
+#if PEBBLE_CHART_ENABLE_SCATTER
+// draws the points of scatter plots
+static void chart_layer_draw_scatter(ChartSurface* pSurface, const ChartLayerData* data, const GRect bounds, const GRect plot) {
+  const uint16_t iPointRadius = (data->iNumOrigPoints < ((unsigned int)bounds.size.w / 3)) ? 3 : 2;
+  for (unsigned int i = 0; i < data->iPointsToDraw; ++i) {
+    if (!clip_outcode(data->pXData[i], data->pYData[i], plot))
+      surface_fill_circle(pSurface, ((GPoint) { .x = data->pXData[i], .y = data->pYData[i] }), iPointRadius);
+  }
+}
+#endif
+
+#if PEBBLE_CHART_ENABLE_BAR || PEBBLE_CHART_ENABLE_HISTOGRAM
+// draws the bars of bar plots and histograms, from the x-axis (kept within the plot)
+static void chart_layer_draw_bars(ChartSurface* pSurface, const ChartLayerData* data, const GRect bounds, const GRect plot) {
+  const int iBase = (data->iYAxisIntercept > (bounds.size.h - data->iMargin)) ? (bounds.size.h - data->iMargin) : data->iYAxisIntercept;
+  for (unsigned int i = 0; i < data->iPointsToDraw; ++i)
+    fill_clipped_rect(pSurface, data->pXData[i] - (data->iBarWidth / 2), data->pYData[i],
+		      data->iBarWidth, iBase - data->pYData[i], plot);
+}
+#endif
+
+#if PEBBLE_CHART_ENABLE_SERIES
+// draws stacked and grouped bars, series by series so that each color is only set once
+static void chart_layer_draw_series_bars(ChartSurface* pSurface, const ChartLayerData* data, const GRect plot) {
+  const int iSlotWidth = (data->typePlot == eGROUPED_BAR) ? data->iBarWidth / (int)data->iNumSeries : data->iBarWidth;
+  const int iGap = ((data->typePlot == eGROUPED_BAR) && (iSlotWidth > 2)) ? 1 : 0;
+  for (unsigned int k = 0; k < data->iNumSeries; ++k) {
+    surface_set_fill_color(pSurface, (data->iSeriesColorsSet & (1 << k)) ? data->aSeriesColors[k] : data->clrPlot);
+    const int iOffset = (data->typePlot == eGROUPED_BAR) ? (int)k * iSlotWidth : 0;
+    for (unsigned int i = 0; i < data->iPointsToDraw; ++i) {
+      const int iEnd = data->pYData[(i * data->iNumSeries) + k];
+      const int iStart = data->pYBaseData[(i * data->iNumSeries) + k];
+      if (iEnd == iStart)
+	continue;
+      fill_clipped_rect(pSurface, data->pXData[i] - (data->iBarWidth / 2) + iOffset, iStart,
+			iSlotWidth - iGap, iEnd - iStart, plot);
+    }
+  }
+  surface_set_fill_color(pSurface, data->clrPlot);
+}
+#endif
+
+#if PEBBLE_CHART_ENABLE_OVERLAYS
+// draws the moving average and the min/max band
+static void chart_layer_draw_overlays(ChartSurface* pSurface, const ChartLayerData* data, const GRect plot) {
+  surface_set_stroke_color(pSurface, data->clrOverlay);
+  for (unsigned int i = 0; (i < data->iPointsToDraw) && ((i + 1) < data->iNumPoints); ++i) {
+    if (data->pAverageData)
+      draw_clipped_line(pSurface, data->pXData[i], data->pAverageData[i], data->pXData[i+1], data->pAverageData[i+1], plot);
+    if (data->pBandMinData) {
+      draw_clipped_line(pSurface, data->pXData[i], data->pBandMinData[i], data->pXData[i+1], data->pBandMinData[i+1], plot);
+      draw_clipped_line(pSurface, data->pXData[i], data->pBandMaxData[i], data->pXData[i+1], data->pBandMaxData[i+1], plot);
+    }
+  }
+  surface_set_stroke_color(pSurface, data->clrPlot);
+}
+#endif
+
+// draws ticks of the given length on the y-axis, every iYTicks from iFrom
+// within [iTop, iBottom], starting with the first one inside of it,
+// as the x-axis and so iFrom may be far outside of the plot
+static void chart_layer_draw_ticks(ChartSurface* pSurface, const ChartLayerData* data, const int iFrom,
+				   const int iTop, const int iBottom, const int iLength) {
+  const int iStep = data->iYTicks;
+  int i = (iFrom < iTop) ? iFrom + (((iTop - iFrom + iStep - 1) / iStep) * iStep)
+    : iFrom - (((iFrom - iTop) / iStep) * iStep);
+  for (; i <= iBottom; i += iStep)
+    surface_draw_line(pSurface,
+		      ((GPoint) {
+			.x = data->iMargin,
+			  .y = i }),
+		      ((GPoint) {
+			.x = data->iMargin + iLength,
+			  .y = i }));
+}
+
+// draws the chart with its current layout onto the surface
+static void chart_layer_draw(ChartLayer* layer, ChartSurface* pSurface) {
+  ChartLayerData* data = get_chart_data(layer);
+  GRect bounds = layer_get_bounds(chart_layer_get_layer(layer));
+
+  // draw background
+  GRect canvas = (GRect) { .origin = { 0, 0 },
+			   .size = { bounds.size.w-1, bounds.size.h-1 } };
+  surface_set_fill_color(pSurface, data->clrCanvas);
+  surface_fill_rect(pSurface, canvas);
+
+  // set color for rest of draw cycle
+  surface_set_fill_color(pSurface, data->clrPlot);
+  surface_set_stroke_color(pSurface, data->clrPlot);
+  if (pSurface->ctx)
+    graphics_context_set_text_color(pSurface->ctx, data->clrPlot);
+  
+  // draw frame
+  if (data->bShowFrame)
+    surface_draw_rect(pSurface, canvas);
+
+  // plot area, anything outside of the axes ranges is clipped to it
+  const GRect plot = (GRect) { .origin = { data->iMargin, data->iMargin },
+			       .size = { bounds.size.w - (2 * data->iMargin), bounds.size.h - (2 * data->iMargin) } };
+
+  if (data->iNumPoints) {
+    // x-axis
+    surface_draw_line(pSurface,
+		      ((GPoint) {
+			.x = data->iMargin,
+			  .y = data->iYAxisIntercept }),
+		      ((GPoint) { 
+			.x = bounds.size.w - data->iMargin,
+			  .y = data->iYAxisIntercept }));
+    
+    // y-axis ticks below the top of the plot, major ones every iYTicks from the x-axis
+    // and minor ones halfway between, away from the x-axis
+    const int iTop = data->iMargin + 1;
+    const int iBottom = bounds.size.h - data->iMargin;
+    const int iAbove = data->iYAxisIntercept - (data->iYTicks / 2);
+    const int iBelow = data->iYAxisIntercept + (data->iYTicks / 2);
+    chart_layer_draw_ticks(pSurface, data, data->iYAxisIntercept, iTop, iBottom, 4);
+    chart_layer_draw_ticks(pSurface, data, iAbove, iTop, (iAbove < iBottom) ? iAbove : iBottom, 2);
+    chart_layer_draw_ticks(pSurface, data, iBelow, (iBelow > iTop) ? iBelow : iTop, iBottom, 2);
+
+    // y-axis
+    surface_draw_line(pSurface,
+		      ((GPoint) {
+			.x = data->iXAxisIntercept,
+			  .y = data->iMargin }),
+		      ((GPoint) { 
+			.x = data->iXAxisIntercept,
+			  .y = bounds.size.h - data->iMargin }));
+
+    // main plot, with the routine for the plot type
+    switch (data->typePlot) {
+    case eLINE:
+      chart_layer_draw_line(pSurface, data, bounds, plot);
+      break;
+#if PEBBLE_CHART_ENABLE_SCATTER
+    case eSCATTER:
+      chart_layer_draw_scatter(pSurface, data, bounds, plot);
+      break;
+#endif
+#if PEBBLE_CHART_ENABLE_BAR || PEBBLE_CHART_ENABLE_HISTOGRAM
+    case eBAR:
+    case eHISTOGRAM:
+      chart_layer_draw_bars(pSurface, data, bounds, plot);
+      break;
+#endif
+#if PEBBLE_CHART_ENABLE_SERIES
+    case eSTACKED_BAR:
+    case eGROUPED_BAR:
+      if (data->pYBaseData)
+	chart_layer_draw_series_bars(pSurface, data, plot);
+      break;
+#endif
+    default:
+      break;
+    }
+
+#if PEBBLE_CHART_ENABLE_OVERLAYS
+    if (data->pAverageData || data->pBandMinData)
+      chart_layer_draw_overlays(pSurface, data, plot);
+#endif
+  }
+}
+
+// function to draw chart
+static void chart_layer_update_func(Layer* l, GContext* ctx) {
+  ChartLayer* layer = (ChartLayer*)l;
+  chart_layer_update_layout(layer);
+
+  ChartLayerData* data = get_chart_data(layer);
+
+  // handle animations
+#if PEBBLE_CHART_ENABLE_ANIMATION
+  if (((data->iNumPoints != data->iPointsToDraw) || data->pMorphData) && !chart_layer_is_animating(data)) {
+    if (!data->bAnimate || !chart_layer_start_animation(layer)) {
+      // cause entire chart to be drawn
+      chart_layer_set_animation_progress(data, ANIMATION_NORMALIZED_MAX);
+    }
+  }
+#else
+  data->iPointsToDraw = data->iNumPoints;
+#endif
+
+  ChartSurface surface = { .ctx = ctx };
+  chart_layer_draw(layer, &surface);
+}
+
+#if PEBBLE_CHART_ENABLE_RENDER
+bool chart_layer_render_to_bitmap(ChartLayer* layer, GBitmap* bitmap) {
+  if (!layer || !bitmap)
+    return false;
+
+  const GBitmapFormat format = gbitmap_get_format(bitmap);
+  uint8_t* pPixels = gbitmap_get_data(bitmap);
+  if (!pPixels || ((format != GBitmapFormat1Bit) && (format != GBitmapFormat8Bit)))
+    return false;
+
+  chart_layer_update_layout(layer);
+
+  // draw the chart completely, finishing any animation
+  ChartLayerData* data = get_chart_data(layer);
+#if PEBBLE_CHART_ENABLE_ANIMATION
+  if (chart_layer_is_animating(data))
+    chart_layer_stop_animation(data);
+  chart_layer_set_animation_progress(data, ANIMATION_NORMALIZED_MAX);
+#else
+  data->iPointsToDraw = data->iNumPoints;
+#endif
+
+  ChartSurface surface = { .ctx = NULL,
+			   .pPixels = pPixels,
+			   .iRowBytes = gbitmap_get_bytes_per_row(bitmap),
+			   .format = format,
+			   .frame = gbitmap_get_bounds(bitmap) };
+  chart_layer_draw(layer, &surface);
+  return true;
+}
+#endif
+
+#if PEBBLE_CHART_ENABLE_PERSIST
+///////////////////////////////////
+// layout persistence
+
+// scales and sampling of the layout, which appending points
+// and the cursor need to map values to and from pixels
+typedef struct {
+  float fXScale;
+  float fYScale;
+  float fLayoutXMin;
+  float fLayoutXMax;
+  float fLayoutYMin;
+  float fLayoutYMax;
+  float fLayoutXSep;
+  uint32_t iSampling;
+  uint32_t iNumSampled;
+} ChartPersistScale;
+
+// header stored under the first persist key
+typedef struct {
+  uint32_t iVersion;
+  int16_t iWidth;
+  int16_t iHeight;
+  int16_t iMargin;
+  uint8_t typePlot;
+  uint8_t iNumSeries;
+  uint8_t bShowFrame;
+  uint8_t bAutoscale;
+  uint8_t typeAverage;
+  uint8_t bShowBand;
+  uint16_t iAverageWindow;
+  uint16_t iHistogramBins;
+  float fAutoscaleHeadroom;
+  float fXMin;
+  float fXMax;
+  float fYMin;
+  float fYMax;
+  uint16_t iNumPoints;
+  int16_t iXAxisIntercept;
+  int16_t iYAxisIntercept;
+  int16_t iYTicks;
+  int16_t iBarWidth;
+  ChartPersistScale scale;
+} ChartPersistHeader;
+
+// number of int16_t values which fit in one persist key
+#define PERSIST_CHUNK_VALUES (PERSIST_DATA_MAX_LENGTH / sizeof(int16_t))
+
+// fills header with the current layout and its cache key
+static void chart_persist_header_init(ChartLayer* layer, ChartPersistHeader* pHeader, const uint32_t version) {
+  ChartLayerData* pData = get_chart_data(layer);
+  GRect bounds = layer_get_bounds(chart_layer_get_layer(layer));
+  memset(pHeader, 0, sizeof(ChartPersistHeader));
+  pHeader->iVersion = version;
+  pHeader->iWidth = bounds.size.w;
+  pHeader->iHeight = bounds.size.h;
+  pHeader->iMargin = pData->iMargin;
+  pHeader->typePlot = pData->typePlot;
+  pHeader->iNumSeries = pData->iNumSeries;
+  pHeader->bShowFrame = pData->bShowFrame;
+  pHeader->bAutoscale = pData->bAutoscale;
+  pHeader->fAutoscaleHeadroom = pData->fAutoscaleHeadroom;
+#if PEBBLE_CHART_ENABLE_OVERLAYS
+  pHeader->typeAverage = pData->typeAverage;
+  pHeader->bShowBand = pData->bShowBand;
+  pHeader->iAverageWindow = pData->rolling.iWindow;
+#endif
+#if PEBBLE_CHART_ENABLE_HISTOGRAM
+  pHeader->iHistogramBins = pData->iHistogramBins;
+#endif
+  pHeader->fXMin = pData->fXMin;
+  pHeader->fXMax = pData->fXMax;
+  pHeader->fYMin = pData->fYMin;
+  pHeader->fYMax = pData->fYMax;
+}
+
+// true if the layout has overlays or bands, which aren't saved with it
+static bool chart_persist_has_overlays(const ChartLayerData* pData) {
+#if PEBBLE_CHART_ENABLE_OVERLAYS
+  if (pData->rolling.pValues)
+    return true;
+#endif
+#if PEBBLE_CHART_ENABLE_BUDGET
+  if (pData->pYMinOrigData)
+    return true;
+#endif
+  return false;
+}
+
+bool chart_layer_persist_layout(ChartLayer* layer, const uint32_t key, const uint32_t version) {
+  if (!layer)
+    return false;
+
+  chart_layer_update_layout(layer);
+  ChartLayerData* pData = get_chart_data(layer);
+  if (!pData->iNumPoints || (pData->iNumPoints > PERSIST_MAX_POINTS) || chart_layer_has_bar_bases(pData) ||
+      chart_persist_has_overlays(pData))
+    return false;
+
+  ChartPersistHeader header;
+  chart_persist_header_init(layer, &header, version);
+  header.iNumPoints = pData->iNumPoints;
+  header.iXAxisIntercept = pData->iXAxisIntercept;
+  header.iYAxisIntercept = pData->iYAxisIntercept;
+  header.iYTicks = pData->iYTicks;
+  header.iBarWidth = pData->iBarWidth;
+  header.scale = (ChartPersistScale) { .fXScale = pData->fXScale,
+				       .fYScale = pData->fYScale,
+				       .fLayoutXMin = pData->fLayoutXMin,
+				       .fLayoutXMax = pData->fLayoutXMax,
+				       .fLayoutYMin = pData->fLayoutYMin,
+				       .fLayoutYMax = pData->fLayoutYMax,
+				       .fLayoutXSep = pData->fLayoutXSep,
+				       .iSampling = pData->iSampling,
+				       .iNumSampled = pData->iNumSampled };
+  if (persist_write_data(key, &header, sizeof(header)) < 0)
+    return false;
+
+  // x-values followed by y-values, split across consecutive keys
+  int16_t chunk[PERSIST_CHUNK_VALUES];
+  const unsigned int iNumValues = 2 * pData->iNumPoints;
+  uint32_t iKey = key + 1;
+  unsigned int iChunk = 0;
+  for (unsigned int i = 0; i < iNumValues; ++i) {
+    chunk[iChunk++] = (i < pData->iNumPoints) ? pData->pXData[i] : pData->pYData[i - pData->iNumPoints];
+    if ((iChunk == PERSIST_CHUNK_VALUES) || (i == iNumValues - 1)) {
+      if (persist_write_data(iKey++, chunk, iChunk * sizeof(int16_t)) < 0)
+	return false;
+      iChunk = 0;
+    }
+  }
+
+  return true;
+}
+
+bool chart_layer_restore_layout(ChartLayer* layer, const uint32_t key, const uint32_t version) {
+  if (!layer || !persist_exists(key) || chart_persist_has_overlays(get_chart_data(layer)))
+    return false;
+
+  // only use the saved layout if it was made for the same data and geometry
+  ChartPersistHeader saved;
+  ChartPersistHeader expected;
+  if (persist_read_data(key, &saved, sizeof(saved)) != (int)sizeof(saved))
+    return false;
+  chart_persist_header_init(layer, &expected, version);
+  expected.iNumPoints = saved.iNumPoints;
+  expected.iXAxisIntercept = saved.iXAxisIntercept;
+  expected.iYAxisIntercept = saved.iYAxisIntercept;
+  expected.iYTicks = saved.iYTicks;
+  expected.iBarWidth = saved.iBarWidth;
+  expected.scale = saved.scale;
+  if (memcmp(&saved, &expected, sizeof(saved)) || !saved.iNumPoints || (saved.iNumPoints > PERSIST_MAX_POINTS))
+    return false;
+
+  int* pXData = (int*)malloc(saved.iNumPoints * sizeof(int));
+  int* pYData = (int*)malloc(saved.iNumPoints * sizeof(int));
+  if (!pXData || !pYData) {
+    free(pXData);
+    free(pYData);
+    return false;
+  }
+
+  int16_t chunk[PERSIST_CHUNK_VALUES];
+  const unsigned int iNumValues = 2 * saved.iNumPoints;
+  uint32_t iKey = key + 1;
+  for (unsigned int i = 0; i < iNumValues; i += PERSIST_CHUNK_VALUES) {
+    const unsigned int iChunk = ((iNumValues - i) < PERSIST_CHUNK_VALUES) ? (iNumValues - i) : PERSIST_CHUNK_VALUES;
+    if (persist_read_data(iKey++, chunk, iChunk * sizeof(int16_t)) != (int)(iChunk * sizeof(int16_t))) {
+      free(pXData);
+      free(pYData);
+      return false;
+    }
+    for (unsigned int j = 0; j < iChunk; ++j) {
+      if ((i + j) < saved.iNumPoints)
+	pXData[i + j] = chunk[j];
+      else
+	pYData[i + j - saved.iNumPoints] = chunk[j];
+    }
+  }
+
+  // swap in the restored layout and draw it without animating
+  ChartLayerData* pData = get_chart_data(layer);
+  chart_layer_free_layout_cache(pData);
+  pData->pXData = pXData;
+  pData->pYData = pYData;
+  pData->iNumPoints = saved.iNumPoints;
+  pData->iPointCapacity = saved.iNumPoints;
+  pData->iXAxisIntercept = saved.iXAxisIntercept;
+  pData->iYAxisIntercept = saved.iYAxisIntercept;
+  pData->iYTicks = saved.iYTicks;
+  pData->iBarWidth = saved.iBarWidth;
+  pData->fXScale = saved.scale.fXScale;
+  pData->fYScale = saved.scale.fYScale;
+  pData->fLayoutXMin = saved.scale.fLayoutXMin;
+  pData->fLayoutXMax = saved.scale.fLayoutXMax;
+  pData->fLayoutYMin = saved.scale.fLayoutYMin;
+  pData->fLayoutYMax = saved.scale.fLayoutYMax;
+  pData->fLayoutXSep = saved.scale.fLayoutXSep;
+  pData->iSampling = saved.scale.iSampling;
+  pData->iNumSampled = saved.scale.iNumSampled;
+  pData->iPointsToDraw = pData->iNumPoints;
+  pData->bLayoutDirty = false;
+
+  layer_mark_dirty(chart_layer_get_layer(layer));
+  return true;
+}
+#endif
+
+#if PEBBLE_CHART_ENABLE_CURSOR
+///////////////////////////////////
+// cursor
+
+#if PEBBLE_CHART_ENABLE_HISTORY
+// finds the history sample closest to x, decoding at most two blocks
+static bool history_find_nearest(ChartHistory* pHistory, const float x, float* pX, float* pY) {
+  if (!pHistory->iNumSamples)
+    return false;
+
+  // first block ending at, or after, x
+  unsigned int iLow = 0;
+  unsigned int iHigh = pHistory->iNumBlocks;
+  while (iLow < iHigh) {
+    const unsigned int iMid = iLow + ((iHigh - iLow) / 2);
+    if (history_get_block(pHistory, iMid)->iLastX < x)
+      iLow = iMid + 1;
+    else
+      iHigh = iMid;
+  }
+  if (iLow == pHistory->iNumBlocks) {
+    *pX = pHistory->iLastX;
+    *pY = pHistory->iLastY;
+    return true;
+  }
+
+  // first sample at, or after, x, and the one before it within the block
+  ChartHistoryCursor cursor;
+  int32_t iX, iY;
+  int32_t iPrevX = 0, iPrevY = 0;
+  bool bPrev = false;
+  history_cursor_init(&cursor, history_get_block(pHistory, iLow));
+  while (history_cursor_next(&cursor, &iX, &iY) && (iX < x)) {
+    iPrevX = iX;
+    iPrevY = iY;
+    bPrev = true;
+  }
+
+  // otherwise the one before it ends the previous block
+  if (!bPrev && iLow && ((x - history_get_block(pHistory, iLow - 1)->iLastX) < (iX - x))) {
+    history_cursor_init(&cursor, history_get_block(pHistory, iLow - 1));
+    while (history_cursor_next(&cursor, &iPrevX, &iPrevY))
+      ;
+    bPrev = true;
+  }
+
+  const bool bUsePrev = bPrev && ((x - iPrevX) <= (iX - x));
+  *pX = bUsePrev ? iPrevX : iX;
+  *pY = bUsePrev ? iPrevY : iY;
+  return true;
+}
+#endif
+
+// finds the data point closest to x, with a binary search of the layout's sort order
+// for series data the y-value is that of the first series
+static bool chart_layer_find_nearest(ChartLayer* layer, const float x, float* pX, float* pY) {
+  ChartLayerData* pData = get_chart_data(layer);
+  if (pData->typePlot == eHISTOGRAM)
+    return false;
+  chart_layer_update_layout(layer);
+#if PEBBLE_CHART_ENABLE_HISTORY
+  if (pData->history.pBlocks)
+    return history_find_nearest(&pData->history, x, pX, pY);
+#endif
+
+  // scatter layouts don't need sorting and restored layouts don't keep it,
+  // so only sort once the cursor is used
+  if (!pData->pSortOrder && pData->pXOrigData && pData->iNumPoints) {
+    pData->pSortOrder = (ChartSortHelper*) malloc(pData->iNumOrigPoints * sizeof(ChartSortHelper));
+    if (!pData->pSortOrder)
+      return false;
+    for (unsigned int i = 0; i < pData->iNumOrigPoints; ++i)
+      pData->pSortOrder[i] = ((ChartSortHelper) { .x_value = pData->pXOrigData[i], .index= i });
+    qsort(pData->pSortOrder, pData->iNumOrigPoints, sizeof(ChartSortHelper), &cmpChartSortHelper);
+  }
+  if (!pData->pSortOrder)
+    return false;
+
+  unsigned int i = search_sorted_x(pData->pSortOrder, pData->iNumOrigPoints, x, false);
+  if ((i == pData->iNumOrigPoints) ||
+      (i && ((x - pData->pSortOrder[i-1].x_value) <= (pData->pSortOrder[i].x_value - x))))
+    --i;
+  *pX = pData->pSortOrder[i].x_value;
+  *pY = pData->pYOrigData[pData->pSortOrder[i].index * pData->iNumSeries];
+  return true;
+}
+
+bool chart_layer_query_nearest(ChartLayer* layer, const int px, float* x, float* y) {
+  if (!layer || !x || !y)
+    return false;
+
+  // pixel column to x-value, with the layout's scale
+  ChartLayerData* pData = get_chart_data(layer);
+  chart_layer_update_layout(layer);
+  if (pData->fXScale == 0)
+    return false;
+  const float fX = ((px - pData->iMargin) / pData->fXScale) + pData->fLayoutXMin - (pData->fLayoutXSep / 2);
+  return chart_layer_find_nearest(layer, fX, x, y);
+}
+
+// draws the cursor through the point closest to its x-value
+static void chart_layer_cursor_update_func(Layer* l, GContext* ctx) {
+  ChartLayer* layer = *(ChartLayer**)layer_get_data(l);
+  ChartLayerData* pData = get_chart_data(layer);
+  float x, y;
+  if ((pData->fCursorX == NOT_SET) || !chart_layer_find_nearest(layer, pData->fCursorX, &x, &y) || !pData->iNumPoints)
+    return;
+
+  GRect bounds = layer_get_bounds(l);
+  const int iX = (int)(pData->fXScale * (x - pData->fLayoutXMin + (pData->fLayoutXSep / 2))) + pData->iMargin;
+  const int iY = chart_layer_map_y(pData, bounds, y);
+  if ((iX < pData->iMargin) || (iX > (bounds.size.w - pData->iMargin)))
+    return;
+
+  graphics_context_set_stroke_color(ctx, pData->clrOverlay);
+  graphics_context_set_fill_color(ctx, pData->clrOverlay);
+  graphics_draw_line(ctx,
+		     ((GPoint) { .x = iX, .y = pData->iMargin }),
+		     ((GPoint) { .x = iX, .y = bounds.size.h - pData->iMargin }));
+  if (!is_bar_plot(pData->typePlot) && (iY >= pData->iMargin) && (iY <= (bounds.size.h - pData->iMargin)))
+    graphics_fill_circle(ctx, ((GPoint) { .x = iX, .y = iY }), 2);
+}
+
+void chart_layer_set_cursor(ChartLayer* layer, const float x) {
+  if (!layer)
+    return;
+
+  // the cursor is drawn by a child layer, so that
+  // moving it doesn't invalidate the layout of the chart
+  ChartLayerData* pData = get_chart_data(layer);
+  GRect bounds = layer_get_bounds(chart_layer_get_layer(layer));
+  if (!pData->pCursorLayer) {
+    pData->pCursorLayer = layer_create_with_data(bounds, sizeof(ChartLayer*));
+    if (!pData->pCursorLayer)
+      return;
+    *(ChartLayer**)layer_get_data(pData->pCursorLayer) = layer;
+    layer_set_update_proc(pData->pCursorLayer, chart_layer_cursor_update_func);
+    layer_add_child(chart_layer_get_layer(layer), pData->pCursorLayer);
+  }
+  else
+    layer_set_frame(pData->pCursorLayer, bounds);
+
+  pData->fCursorX = x;
+  layer_mark_dirty(pData->pCursorLayer);
+}
+
+void chart_layer_clear_cursor(ChartLayer* layer) {
+  if (!layer)
+    return;
+
+  ChartLayerData* pData = get_chart_data(layer);
+  if (pData->fCursorX != NOT_SET) {
+    pData->fCursorX = NOT_SET;
+    if (pData->pCursorLayer)
+      layer_mark_dirty(pData->pCursorLayer);
+  }
+}
+#endif
+
+#if PEBBLE_CHART_ENABLE_SPARKLINE
+///////////////////////////////////
+// sparkline layer
+
+#define SPARKLINE_LEVELS 255 // largest quantized y-value
+#define SPARKLINE_MAX_OFFSET 1e9f // limit in pixels of the mapped y-values, keeps the fixed-point math in range
+
+typedef struct {
+  uint8_t aYData[SPARKLINE_MAX_POINTS]; // quantized, 0 at fDataMin and SPARKLINE_LEVELS at fDataMax
+  uint8_t iNumPoints;
+  GColor clrLine;
+  float fDataMin;
+  float fDataMax;
+  float fYMin;
+  float fYMax;
+} SparklineLayerData;
+
+// helper to extract SparklineLayerData from SparklineLayer
+static SparklineLayerData* get_sparkline_data(SparklineLayer* layer) {
+  return (SparklineLayerData*)(layer_get_data(sparkline_layer_get_layer(layer)));
+}
+
+// converts pixels to 16.16 fixed-point, clamped to +/- SPARKLINE_MAX_OFFSET
+static int64_t to_fixed(float fPixels) {
+  if (fPixels > SPARKLINE_MAX_OFFSET)
+    fPixels = SPARKLINE_MAX_OFFSET;
+  else if (fPixels < -SPARKLINE_MAX_OFFSET)
+    fPixels = -SPARKLINE_MAX_OFFSET;
+  return (int64_t)(fPixels * 65536);
+}
+
+// maps and draws the points in one pass, there is no cached layout
+static void sparkline_layer_update_func(Layer* l, GContext* ctx) {
+  SparklineLayerData* data = get_sparkline_data((SparklineLayer*)l);
+  GRect bounds = layer_get_bounds(l);
+  if (!data->iNumPoints || (bounds.size.w < 1) || (bounds.size.h < 1))
+    return;
+
+  const int iHeight = bounds.size.h - 1;
+
+  // pixel y of a quantized value v is (iOffset - v * iStep) in 16.16 fixed-point
+  const float fMin = (data->fYMin != NOT_SET) ? data->fYMin : data->fDataMin;
+  const float fMax = (data->fYMax != NOT_SET) ? data->fYMax : data->fDataMax;
+  int64_t iOffset = (iHeight / 2) << 16;
+  int64_t iStep = 0;
+  if (fMax > fMin) {
+    const float fPixelsPerUnit = iHeight / (fMax - fMin);
+    iOffset = to_fixed((fMax - data->fDataMin) * fPixelsPerUnit);
+    iStep = to_fixed((data->fDataMax - data->fDataMin) * fPixelsPerUnit) / SPARKLINE_LEVELS;
+  }
+
+  // x-values are evenly spaced, the last point at the right edge
+  const int32_t iXStep = (data->iNumPoints > 1) ? ((bounds.size.w - 1) << 16) / (data->iNumPoints - 1) : 0;
+  int32_t iX = (data->iNumPoints > 1) ? 0 : ((bounds.size.w - 1) << 16);
+
+  graphics_context_set_stroke_color(ctx, data->clrLine);
+  GPoint prev = { .x = 0, .y = 0 };
+  for (unsigned int i = 0; i < data->iNumPoints; ++i, iX += iXStep) {
+    int64_t y = (iOffset - data->aYData[i] * iStep + 0x8000) >> 16;
+    if (y < 0)
+      y = 0;
+    else if (y > iHeight)
+      y = iHeight;
+    const GPoint pt = { .x = bounds.origin.x + ((iX + 0x8000) >> 16), .y = bounds.origin.y + y };
+
+    if (i)
+      graphics_draw_line(ctx, prev, pt);
+    else if (data->iNumPoints == 1)
+      graphics_draw_pixel(ctx, pt);
+    prev = pt;
+  }
+}
+
+SparklineLayer* sparkline_layer_create(GRect frame) {
+  SparklineLayer* layer = (SparklineLayer*)layer_create_with_data(frame, sizeof(SparklineLayerData));
+  if (!layer)
+    return layer;
+
+  // set defaults
+  SparklineLayerData* data = get_sparkline_data(layer);
+  data->iNumPoints = 0;
+  data->clrLine = GColorWhite;
+  data->fDataMin = 0;
+  data->fDataMax = 0;
+  data->fYMin = NOT_SET;
+  data->fYMax = NOT_SET;
+
+  layer_set_update_proc(sparkline_layer_get_layer(layer), sparkline_layer_update_func);
+
+  return layer;
+}
+
+void sparkline_layer_destroy(SparklineLayer* layer) {
+  if (layer)
+    layer_destroy(sparkline_layer_get_layer(layer));
+}
+
+Layer* sparkline_layer_get_layer(SparklineLayer* layer) {
+  return (Layer*)layer;
+}
+
+// samples and quantizes the values into the inline storage
+void sparkline_layer_set_data(SparklineLayer* layer,
+			      const void* pY,
+			      const ChartDataType typeY,
+			      const unsigned int iNumPoints) {
+  if (!layer)
+    return;
+
+  SparklineLayerData* data = get_sparkline_data(layer);
+  const unsigned int iNumKept = (iNumPoints < SPARKLINE_MAX_POINTS) ? iNumPoints : SPARKLINE_MAX_POINTS;
+  const unsigned int iLast = iNumPoints - 1;
+  const unsigned int iKeptLast = iNumKept - 1;
+
+  // range of the kept values, the others are never drawn
+  float fMin = 0;
+  float fMax = 0;
+  for (unsigned int i = 0; i < iNumKept; ++i) {
+    const float y = read_value(pY, typeY, iKeptLast ? (i * iLast / iKeptLast) : 0);
+    if (!i || (y < fMin))
+      fMin = y;
+    if (!i || (y > fMax))
+      fMax = y;
+  }
+
+  const float fScale = (fMax > fMin) ? SPARKLINE_LEVELS / (fMax - fMin) : 0;
+  for (unsigned int i = 0; i < iNumKept; ++i) {
+    const float y = read_value(pY, typeY, iKeptLast ? (i * iLast / iKeptLast) : 0);
+    data->aYData[i] = (uint8_t)((y - fMin) * fScale + 0.5f);
+  }
+  data->iNumPoints = iNumKept;
+  data->fDataMin = fMin;
+  data->fDataMax = fMax;
+
+  layer_mark_dirty(sparkline_layer_get_layer(layer));
+}
+
+void sparkline_layer_set_color(SparklineLayer* layer, GColor color) {
+  if (layer) {
+    get_sparkline_data(layer)->clrLine = color;
+    layer_mark_dirty(sparkline_layer_get_layer(layer));
+  }
+}
+
+void sparkline_layer_set_range(SparklineLayer* layer, float ymin, float ymax) {
+  if (layer) {
+    SparklineLayerData* data = get_sparkline_data(layer);
+    data->fYMin = ymin;
+    data->fYMax = ymax;
+    layer_mark_dirty(sparkline_layer_get_layer(layer));
+  }
+}
+
+void sparkline_layer_clear_range(SparklineLayer* layer) {
+  sparkline_layer_set_range(layer, NOT_SET, NOT_SET);
+}
+#endif
+
 ///////////////////////////////////
 // math helpers
 
 static int closest_log10(float num) {
   int log = 0;
-  if (num < 0)
+  if (num <= 0)
     log = 0;
   else if (num > 1.0) {
     while (num > 10) {
@@ -587,7 +3543,7 @@ static int closest_log10(float num) {
     }
   }
   else {
-    while (num < 10) {
+    while (num < 1.0) {
       num = num * 10;
       --log;
     }
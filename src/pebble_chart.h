@@ -2,6 +2,54 @@
 
 #include <pebble.h>
 
+//! Build-time configuration of the features compiled into the library.
+//! Define any of these as 0 (e.g. with `ctx.env.CFLAGS.append(...)` in the
+//! wscript) to leave the feature, and its functions in this header, out of
+//! the app. Plot types which are compiled out are ignored by
+//! chart_layer_set_plot_type().
+#ifndef PEBBLE_CHART_ENABLE_ANIMATION
+#define PEBBLE_CHART_ENABLE_ANIMATION 1 // animated drawing of the points
+#endif
+#ifndef PEBBLE_CHART_ENABLE_SCATTER
+#define PEBBLE_CHART_ENABLE_SCATTER 1 // eSCATTER plots
+#endif
+#ifndef PEBBLE_CHART_ENABLE_BAR
+#define PEBBLE_CHART_ENABLE_BAR 1 // eBAR plots
+#endif
+#ifndef PEBBLE_CHART_ENABLE_HISTOGRAM
+#define PEBBLE_CHART_ENABLE_HISTOGRAM 1 // eHISTOGRAM plots and samples
+#endif
+#ifndef PEBBLE_CHART_ENABLE_SERIES
+#define PEBBLE_CHART_ENABLE_SERIES 1 // eSTACKED_BAR/eGROUPED_BAR plots and series data
+#endif
+#ifndef PEBBLE_CHART_ENABLE_HISTORY
+#define PEBBLE_CHART_ENABLE_HISTORY 1 // compressed history store
+#endif
+#ifndef PEBBLE_CHART_ENABLE_OVERLAYS
+#define PEBBLE_CHART_ENABLE_OVERLAYS 1 // moving average and min/max band
+#endif
+#ifndef PEBBLE_CHART_ENABLE_PERSIST
+#define PEBBLE_CHART_ENABLE_PERSIST 1 // saving and restoring the layout
+#endif
+#ifndef PEBBLE_CHART_ENABLE_CURSOR
+#define PEBBLE_CHART_ENABLE_CURSOR 1 // cursor and nearest-point lookup
+#endif
+#ifndef PEBBLE_CHART_ENABLE_BUDGET
+#define PEBBLE_CHART_ENABLE_BUDGET 1 // memory budget for the chart data
+#endif
+#ifndef PEBBLE_CHART_ENABLE_SPARKLINE
+#define PEBBLE_CHART_ENABLE_SPARKLINE 1 // SparklineLayer
+#endif
+#ifndef PEBBLE_CHART_ENABLE_RENDER
+#ifdef PBL_SDK_3
+#define PEBBLE_CHART_ENABLE_RENDER 1 // rendering charts into bitmaps, needs SDK 3
+#else
+#define PEBBLE_CHART_ENABLE_RENDER 0
+#endif
+#endif
+#if PEBBLE_CHART_ENABLE_RENDER && !defined(PBL_SDK_3)
+#error "PEBBLE_CHART_ENABLE_RENDER needs SDK 3 for its bitmap and color APIs"
+#endif
 
 struct ChartLayer;
 typedef struct ChartLayer ChartLayer;
@@ -20,6 +68,9 @@ typedef struct ChartLayer ChartLayer;
 //! * Show Frame: false
 //! * Animate: true
 //! * Animation Duration: 1500 (ms)
+//! * Autoscale: false
+//! * Overlays: None
+//! * Overlay color: GColorWhite
 //!
 //! @param frame The frame with which to initialize the ChartLayer
 //! @return A pointer to the ChartLayer. `NULL` if the ChartLayer could not
@@ -64,25 +115,248 @@ void chart_layer_set_data(ChartLayer* layer,
 			  const ChartDataType typeY,
 			  const unsigned int iNumPoints);
 
+#if PEBBLE_CHART_ENABLE_BUDGET
+//! Sets a memory budget for the data set through chart_layer_set_data() and
+//! chart_layer_ingest_packed().  Data which doesn't fit in the budget as
+//! points (8 bytes each) is aggregated as it is set, into time buckets which
+//! each span the same range of x-values (20 bytes each): whenever all the
+//! buckets are used and a point falls outside of the last one, the span is
+//! doubled and the buckets which then share a span are merged, so gaps in the
+//! data stay gaps.  A bucket is plotted at the mean x- and y-value of its
+//! points, and the range between its minimum and maximum y-value is drawn as
+//! a band in the overlay color (unless a band overlay is set, see
+//! chart_layer_set_overlays()).
+//! Data over the budget should be in order of increasing x-value.
+//! The budget only covers the stored data, drawing the chart needs some
+//! more memory for up to one point per pixel of the chart's width.
+//! Takes effect the next time data is set.
+//! @param layer The ChartLayer to which to set the budget
+//! @param iBytes The budget in bytes, 0 for no fixed budget
+//! @param iHeapPercent The budget as a percentage of the heap that is free
+//! when data is set, 0 for none.  If both are given, the smaller one applies.
+void chart_layer_set_memory_budget(ChartLayer* layer, const size_t iBytes, const unsigned int iHeapPercent);
+#endif
+
+//! Maximum number of series supported by chart_layer_set_series_data()
+#define CHART_MAX_SERIES 4
+
+#if PEBBLE_CHART_ENABLE_SERIES
+//! Sets chart data with several y-values (series) per x-value,
+//! for stacked and grouped bar charts (see chart_layer_set_plot_type()).
+//! Other plot types show nothing for data with more than one series.
+//! X and Y values can be stack allocated, as they will
+//! be copied internal to the ChartLayer.
+//! @param layer The ChartLayer to display the chart
+//! @param pX The array containing the x-values
+//! @param typeX The data type of `pX`'s values
+//! @param pY The array containing the y-values, `iNumSeries` consecutive
+//! values for each x-value (i.e. `pY[i * iNumSeries + k]` is the value of
+//! series `k` at `pX[i]`)
+//! @param typeY The data type of `pY`'s values
+//! @param iNumPoints The number of x-values in `pX`
+//! @param iNumSeries The number of series, at most CHART_MAX_SERIES
+void chart_layer_set_series_data(ChartLayer* layer,
+				 const void* pX,
+				 const ChartDataType typeX,
+				 const void* pY,
+				 const ChartDataType typeY,
+				 const unsigned int iNumPoints,
+				 const unsigned int iNumSeries);
+#endif
+
+#if PEBBLE_CHART_ENABLE_HISTOGRAM
+//! Sets raw samples into the chart, to be binned by a histogram
+//! (see chart_layer_set_plot_type()).
+//! Only the samples are stored, with no x-values, so other plot types
+//! show nothing for data set this way.
+//! Samples can be stack allocated, as they will be copied
+//! internal to the ChartLayer.
+//! @param layer The ChartLayer to display the histogram
+//! @param pSamples The array containing the samples
+//! @param typeSamples The data type of `pSamples`'s values
+//! @param iNumSamples The number of samples in `pSamples`
+void chart_layer_set_samples(ChartLayer* layer,
+			     const void* pSamples,
+			     const ChartDataType typeSamples,
+			     const unsigned int iNumSamples);
+#endif
+
+//! Version number expected in the first byte of packed chart data
+#define CHART_PACKED_VERSION 1
+//! Size in bytes of the fixed part of the packed chart data header
+#define CHART_PACKED_HEADER_SIZE 4
+//! Packed chart data flag: x-values are evenly spaced and not sent per sample
+#define CHART_PACKED_UNIFORM_X 0x01
+
+//! Sets chart data from a compact packed buffer, such as one received
+//! through AppMessage or DataLogging, decoding it directly into
+//! the chart without intermediate arrays.
+//!
+//! The packed format is:
+//! * byte 0: CHART_PACKED_VERSION
+//! * byte 1: flags (CHART_PACKED_UNIFORM_X)
+//! * byte 2: number of decimal places of the x-values
+//! * byte 3: number of decimal places of the y-values
+//! * varint: number of samples
+//! * if CHART_PACKED_UNIFORM_X: svarint first x-value, svarint x spacing
+//! * per sample: svarint x delta (omitted if CHART_PACKED_UNIFORM_X),
+//!   svarint y delta
+//!
+//! Values are integers scaled by 10^(decimal places), e.g. 1.25 with
+//! 2 decimal places is encoded as 125.  Deltas are from the previous
+//! sample (from 0 for the first sample).  A varint is an unsigned
+//! LEB128 integer (7 bits per byte, least significant group first, high
+//! bit set on all but the last byte); an svarint is a zigzag-encoded
+//! varint (0, -1, 1, -2, ... map to 0, 1, 2, 3, ...).
+//!
+//! If the buffer is malformed, the chart is left with no data.
+//! @param layer The ChartLayer to display the chart
+//! @param pPacked The packed data
+//! @param iLength The length of `pPacked` in bytes
+//! @return `true` if the data was decoded, `false` otherwise
+bool chart_layer_ingest_packed(ChartLayer* layer, const uint8_t* pPacked, const size_t iLength);
+
+//! Sets whether the y-axis range is chosen automatically.
+//! When autoscaling, the range is only changed when a value falls
+//! outside of it, or when the data, including the extra space described
+//! below, shrinks to less than half of it.
+//! A new range includes extra space above and below the data, and is
+//! rounded out to a step of 1, 2 or 5 times a power of ten, about a fifth
+//! of the range.
+//! The range is kept when new data is set, so that a chart whose data
+//! is updated regularly doesn't rescale with every update.
+//! For charts using the history store (see chart_layer_set_history_capacity()),
+//! the x-axis is autoscaled in the same way, with the extra space only
+//! added after the newest sample, so that most appended samples fit
+//! without rescaling the rest of the chart.
+//! Minimums/maximums set through chart_layer_set_xmin() etc. take precedence.
+//! Will redraw chart if chart data is set.
+//! @param layer The ChartLayer to autoscale
+//! @param bAutoscale `true` to autoscale, `false` to fit the axes exactly to the data
+//! @param fHeadroom The extra space to add when rescaling, as a fraction of
+//! the range of the data (e.g. 0.1 for 10%)
+void chart_layer_set_autoscale(ChartLayer* layer, bool bAutoscale, float fHeadroom);
+
+//! Enum of moving average overlays
+typedef enum {
+  eNO_AVERAGE,
+  eSIMPLE_AVERAGE,
+  eEXPONENTIAL_AVERAGE
+} ChartAverageType;
+
+#if PEBBLE_CHART_ENABLE_OVERLAYS
+//! Sets the overlays drawn on top of the plot, computed by the chart
+//! from the plotted data: a moving average and/or a band between the
+//! rolling minimum and maximum.
+//! The statistics are computed over the last `iWindow` data points
+//! (the exponential average uses a smoothing factor of 2 / (iWindow + 1)),
+//! including points left out when the data is sampled to fit the chart width.
+//! They are updated incrementally as points are appended to the history
+//! store (see chart_layer_set_history_capacity()).
+//! Overlays are not drawn on scatter charts.
+//! Will redraw chart if chart data is set.
+//! @param layer The ChartLayer to which to set the overlays
+//! @param typeAverage The type of moving average to draw, if any
+//! @param bShowBand `true` if the rolling minimum/maximum band should be drawn,
+//! `false` otherwise
+//! @param iWindow The number of data points in the rolling window.  0 disables
+//! the overlays.
+//! @return `true` if the overlays were set, `false` if the rolling window
+//! could not be allocated, in which case no overlays are drawn
+bool chart_layer_set_overlays(ChartLayer* layer, const ChartAverageType typeAverage, const bool bShowBand, const unsigned int iWindow);
+#endif
+
+//! Sets the color of the overlays (see chart_layer_set_overlays())
+//! and of the cursor (see chart_layer_set_cursor())
+//! Will redraw chart if chart data is set.
+//! @param layer The ChartLayer to which to set the overlay color
+//! @param color The new `GColor` for the overlays and the cursor
+void chart_layer_set_overlay_color(ChartLayer* layer, GColor color);
+
+#if PEBBLE_CHART_ENABLE_HISTORY
+//! Switches the chart to a compressed history store, to which data
+//! is added one sample at a time with chart_layer_append_point().
+//! Samples are delta-of-delta encoded and bit-packed, as in Gorilla, into
+//! fixed-size blocks of 128 bytes.  Regularly spaced samples which change by
+//! less than 8 take 7 bits, so a block holds about 118 of them, compared to
+//! 16 points of the data given to chart_layer_set_data(), which takes 8 bytes
+//! a point; larger changes take up to 9 bytes.  When all blocks are full,
+//! the oldest block is discarded.  Blocks entirely outside the x-axis minimum/maximum are
+//! skipped without being decoded when the chart is drawn.
+//! Any data previously set into the chart is discarded, and setting data
+//! through chart_layer_set_data() or chart_layer_ingest_packed() discards
+//! the history.
+//! @param layer The ChartLayer in which to store the history
+//! @param iNumBlocks The number of blocks to allocate.  0 disables the
+//! history store.
+//! @return `true` if the history store could be allocated, `false` otherwise
+bool chart_layer_set_history_capacity(ChartLayer* layer, const unsigned int iNumBlocks);
+
+//! Appends a sample to the chart's history store
+//! (see chart_layer_set_history_capacity()).
+//! Samples must be appended in order of increasing x-value.
+//! Will redraw chart.
+//! @param layer The ChartLayer to which to append the sample
+//! @param x The x-value of the sample
+//! @param y The y-value of the sample
+//! @return `true` if the sample was appended, `false` if the history
+//! store is not enabled or `x` is less than the previous x-value
+bool chart_layer_append_point(ChartLayer* layer, const int x, const int y);
+#endif
+
 //! Enum of supported plot types
 typedef enum {
   eLINE,
   eSCATTER,
-  eBAR
+  eBAR,
+  eHISTOGRAM,
+  eSTACKED_BAR,
+  eGROUPED_BAR
 } ChartPlotType;
 
-//! Sets the plot type (i.e. line, scatter, or bar)
+//! Sets the plot type (i.e. line, scatter, bar, histogram, stacked bar, or grouped bar)
+//! Plot types compiled out of the library (see PEBBLE_CHART_ENABLE_BAR etc.)
+//! are ignored.
+//! Histograms count the y-values of the chart data (or the samples set
+//! through chart_layer_set_samples()) into bins, and draw a bar for each bin.
+//! Histograms are not drawn from the history store.
+//! Stacked and grouped bars draw every series of the data set through
+//! chart_layer_set_series_data(), stacked on top of each other (positive
+//! values upwards and negative values downwards from 0) or side by side.
 //! Will redraw chart if chart data is set.
 //! @param layer The ChartLayer to which to set the plot type
 //! @param type The new plot type
 void chart_layer_set_plot_type(ChartLayer* layer, const ChartPlotType type);
 
+#if PEBBLE_CHART_ENABLE_HISTOGRAM
+//! Sets the number of bins of histograms.
+//! By default, there is a bin for every 4 pixels of the chart width.
+//! The bins evenly divide the x-axis, which ranges from the smallest to the
+//! largest sample unless its minimum/maximum are set.  Samples outside of
+//! the x-axis range are not counted.
+//! Will redraw chart if chart data is set.
+//! @param layer The ChartLayer to which to set the number of bins
+//! @param iNumBins The number of bins, no more than the width of the chart
+//! in pixels.  0 restores the default.
+void chart_layer_set_histogram_bins(ChartLayer* layer, const unsigned int iNumBins);
+#endif
+
 //! Sets the color of the drawn items on the chart
 //! Will redraw chart if chart data is set.
 //! @param layer The ChartLayer to which to set the plot color
 //! @param color The new `GColor` for the drawn items
 void chart_layer_set_plot_color(ChartLayer* layer, GColor color);
 
+#if PEBBLE_CHART_ENABLE_SERIES
+//! Sets the color of one series of stacked or grouped bar charts.
+//! Series without a color set are drawn with the plot color.
+//! Will redraw chart if chart data is set.
+//! @param layer The ChartLayer to which to set the series color
+//! @param iSeries The index of the series, less than CHART_MAX_SERIES
+//! @param color The new `GColor` for the series
+void chart_layer_set_series_color(ChartLayer* layer, const unsigned int iSeries, GColor color);
+#endif
+
 //! Set the background color of the chart
 //! Will redraw chart if chart data is set.
 //! @param layer The ChartLayer to which to set the canvas color
@@ -109,6 +383,8 @@ void chart_layer_show_points_on_line(ChartLayer* layer, bool bShow);
 void chart_layer_set_margin(ChartLayer* layer, int margin);
 
 //! Sets the minimum value of the x-axis.
+//! Points left of it are culled when laying out the chart,
+//! anything drawn outside of the axes ranges is clipped.
 //! Will redraw chart if chart data is set.
 //! @param layer The ChartLayer to which to set the minimum x-axis value
 //! @param xmin The new minimum value for the x-axis
@@ -159,10 +435,16 @@ void chart_layer_clear_ymax(ChartLayer* layer);
 //! @param bShow `true` if the frame should be drawn, `false` otherwise
 void chart_layer_show_frame(ChartLayer* layer, bool bShow);
 
+struct ChartAnimator;
+typedef struct ChartAnimator ChartAnimator;
+
+#if PEBBLE_CHART_ENABLE_ANIMATION
 //! Sets whether or not the initial drawing of the chart
 //! should be animated or not.
 //! When animated, the points/bars will be drawn
-//! on the chart over the duration of the animation
+//! on the chart over the duration of the animation.
+//! Unless the chart is driven by a ChartAnimator (see chart_layer_set_animator()),
+//! its Animation is created the first time it is needed.
 //! @param layer The ChartLayer to which to toggle the animation
 //! @param bAnimate `true` if the drawing should be animated, `false` otherwise
 void chart_layer_animate(ChartLayer* layer, bool bAnimate);
@@ -172,3 +454,191 @@ void chart_layer_animate(ChartLayer* layer, bool bAnimate);
 //! @param layer The ChartLayer to which to apply the duration
 //! @param ms The duration of the animation in milliseconds
 void chart_layer_set_animation_duration(ChartLayer* layer, const uint32_t ms);
+
+//! Sets whether the chart morphs when its data or configuration changes
+//! after it has been completely drawn: the points move from their previous
+//! positions to the new ones over the duration of the animation, instead of
+//! the new chart being drawn from scratch.  Only the y-positions move; new
+//! points start from the previous line at the same x-position.  The axes and
+//! overlays are drawn at their new positions straight away.
+//! Stacked and grouped bar charts don't morph.
+//! Has no impact if animation is turned off.
+//! @param layer The ChartLayer to which to toggle morphing
+//! @param bMorph `true` if changes should morph the chart, `false` otherwise
+void chart_layer_set_morph(ChartLayer* layer, bool bMorph);
+
+//! Creates a ChartAnimator, which drives the drawing animations of all the
+//! charts registered with it (see chart_layer_set_animator()) from a single
+//! Animation, e.g. for a window showing several charts.
+//! On every frame, it advances each animating chart and then marks only
+//! `root` dirty, instead of each chart marking its own layer dirty.
+//! @param root The layer to redraw on every frame, typically the root layer
+//! of the window, which must contain all the registered charts
+//! @return A pointer to the ChartAnimator. `NULL` if the ChartAnimator could
+//! not be created
+ChartAnimator* chart_animator_create(Layer* root);
+
+//! Destroys a ChartAnimator previously created by chart_animator_create.
+//! Charts still registered with it go back to animating themselves.
+//! @param animator The ChartAnimator to destroy
+void chart_animator_destroy(ChartAnimator* animator);
+
+//! Registers the chart with a ChartAnimator, which then drives its drawing
+//! animation in place of an Animation of its own.
+//! The animation duration and whether to animate at all are still set per
+//! chart, through chart_layer_set_animation_duration() and chart_layer_animate().
+//! A chart is registered with at most one ChartAnimator at a time.
+//! @param layer The ChartLayer to register
+//! @param animator The ChartAnimator to drive the chart's animation, or
+//! `NULL` for the chart to animate itself
+void chart_layer_set_animator(ChartLayer* layer, ChartAnimator* animator);
+#endif
+
+#if PEBBLE_CHART_ENABLE_PERSIST
+//! Saves the chart's computed layout (the pixel positions of the plotted
+//! points, axes and ticks, and the scales mapping values to pixels, which
+//! the cursor and appended points rely on) into persistent storage, so that it can be
+//! shown by chart_layer_restore_layout() on the next launch without
+//! redoing the layout or replaying the animation.
+//! The layout is saved under `key` and the keys directly following it
+//! (at most 9 keys in total); no other data should be persisted in that range.
+//! Charts with more than 512 displayed points are not saved, nor are series
+//! charts, or charts with overlays (see chart_layer_set_overlays()) or with
+//! data aggregated over the memory budget, as their bands aren't saved.
+//! @param layer The ChartLayer whose layout to save
+//! @param key The first persist key to use
+//! @param version Identifies the data set the layout was computed from,
+//! e.g. a counter the app increments whenever its data changes
+//! @return `true` if the layout was saved, `false` otherwise
+bool chart_layer_persist_layout(ChartLayer* layer, const uint32_t key, const uint32_t version);
+
+//! Restores a layout previously saved by chart_layer_persist_layout().
+//! The saved layout is only used if it was saved with the same `version`
+//! and the chart still has the same size, margin, frame, plot type, number of
+//! series, histogram bins, overlay and autoscale settings, and axis
+//! minimums/maximums; otherwise the chart is left unchanged.  Charts with
+//! overlays or with data aggregated over the memory budget aren't restored.
+//! On success, the chart is drawn immediately (without animation) and any
+//! pending relayout is skipped, so this should be called after
+//! chart_layer_set_data() and the other configuration calls.
+//! The restored layout stays in place until the data or the configuration
+//! of the chart changes.
+//! @param layer The ChartLayer to which to restore the layout
+//! @param key The first persist key used when saving
+//! @param version Identifies the data set which the chart is expected to show
+//! @return `true` if the saved layout was restored, `false` otherwise
+bool chart_layer_restore_layout(ChartLayer* layer, const uint32_t key, const uint32_t version);
+#endif
+
+#if PEBBLE_CHART_ENABLE_CURSOR
+//! Shows a cursor, a vertical line through the data point closest to `x`.
+//! Moving the cursor keeps the layout of the chart, though the system still
+//! redraws the chart along with the cursor.
+//! Not supported for histograms.
+//! @param layer The ChartLayer on which to show the cursor
+//! @param x The x-value at which to place the cursor
+void chart_layer_set_cursor(ChartLayer* layer, const float x);
+
+//! Hides the cursor set by chart_layer_set_cursor()
+//! @param layer The ChartLayer on which to hide the cursor
+void chart_layer_clear_cursor(ChartLayer* layer);
+
+//! Finds the data point closest to a pixel column of the chart, e.g. for
+//! stepping a cursor across the chart (see chart_layer_set_cursor()).
+//! The search is a binary search of the data sorted by x-value, which is
+//! kept from the last layout. For series data, `*y` is the value of the
+//! first series. Not supported for histograms.
+//! @param layer The ChartLayer to search
+//! @param px The pixel column, relative to the chart's bounds
+//! @param x Set to the x-value of the closest point
+//! @param y Set to the y-value of the closest point
+//! @return `true` if a point was found, `false` otherwise
+bool chart_layer_query_nearest(ChartLayer* layer, const int px, float* x, float* y);
+#endif
+
+#if PEBBLE_CHART_ENABLE_RENDER
+//! Renders the chart into a bitmap instead of the screen, e.g. to draw it
+//! ahead of time and show the image in a menu or when its window is pushed.
+//! The layer does not need to be in a window. The layout and drawing are
+//! the same as when the layer is drawn, with the layer's bounds at the
+//! origin of the bitmap; anything outside the bitmap is clipped.
+//! Only available with SDK 3, which provides access to the bitmap's pixels.
+//! The chart is drawn completely, as at the end of its animation, and an
+//! animation which is running is finished. The cursor is not drawn.
+//! @param layer The ChartLayer to render
+//! @param bitmap The bitmap to draw into, either GBitmapFormat1Bit or
+//! GBitmapFormat8Bit
+//! @return `true` if the chart was rendered, `false` if the layer or the
+//! bitmap is NULL or the format of the bitmap is not supported
+bool chart_layer_render_to_bitmap(ChartLayer* layer, GBitmap* bitmap);
+#endif
+
+#if PEBBLE_CHART_ENABLE_SPARKLINE
+//! Maximum number of points kept by a SparklineLayer
+#define SPARKLINE_MAX_POINTS 64
+
+struct SparklineLayer;
+typedef struct SparklineLayer SparklineLayer;
+
+//! Creates a new SparklineLayer on the heap: a bare trend line for small
+//! spaces, e.g. when showing many charts on one screen.
+//! Unlike a ChartLayer, it has no axes, frame, background or animation, and
+//! allocates nothing beyond the layer itself; the line is drawn straight from
+//! at most SPARKLINE_MAX_POINTS y-values stored inline, one byte each.
+//! The y-values are evenly spaced across the width of the layer.
+//!
+//! * Line color: GColorWhite
+//! * Y Minimum: None
+//! * Y Maximum: None
+//!
+//! @param frame The frame with which to initialize the SparklineLayer
+//! @return A pointer to the SparklineLayer. `NULL` if the SparklineLayer
+//! could not be created
+SparklineLayer* sparkline_layer_create(GRect frame);
+
+//! Destroys a SparklineLayer previously created by sparkline_layer_create.
+//!
+//! @param layer The SparklineLayer to destroy
+void sparkline_layer_destroy(SparklineLayer* layer);
+
+//! Gets the Layer of the sparkline layer, e.g. for adding it to a window.
+//! @param layer Pointer to the SparklineLayer for which to get the Layer
+//! @return The Layer of the sparkline layer.
+Layer* sparkline_layer_get_layer(SparklineLayer* layer);
+
+//! Sets the y-values of the sparkline, oldest first.
+//! The values are not kept: they are quantized to 256 levels between their
+//! minimum and maximum as they are set.  If there are more than
+//! SPARKLINE_MAX_POINTS values, an evenly spaced sampling of them
+//! (always including the first and the last value) is kept.
+//! Will redraw the sparkline.
+//! @param layer The SparklineLayer to display the values
+//! @param pY The array containing the y-values
+//! @param typeY The data type of `pY`'s values
+//! @param iNumPoints The number of values in `pY`
+void sparkline_layer_set_data(SparklineLayer* layer,
+			      const void* pY,
+			      const ChartDataType typeY,
+			      const unsigned int iNumPoints);
+
+//! Sets the color of the line
+//! Will redraw the sparkline.
+//! @param layer The SparklineLayer to which to set the color
+//! @param color The new `GColor` for the line
+void sparkline_layer_set_color(SparklineLayer* layer, GColor color);
+
+//! Sets the range of y-values spanning the height of the sparkline, e.g.
+//! so that several sparklines share a scale.  Values outside of the range
+//! are drawn at the top or bottom edge.
+//! By default, the range is that of the values set.
+//! Will redraw the sparkline.
+//! @param layer The SparklineLayer to which to set the range
+//! @param ymin The y-value drawn at the bottom edge
+//! @param ymax The y-value drawn at the top edge
+void sparkline_layer_set_range(SparklineLayer* layer, float ymin, float ymax);
+
+//! Clears a previously set range of y-values
+//! Will redraw the sparkline.
+//! @param layer The SparklineLayer to which to clear the range
+void sparkline_layer_clear_range(SparklineLayer* layer);
+#endif
@@ -4,8 +4,13 @@
 static Window *window;
 static TextLayer *text_layer;
 static ChartLayer* chart_layer;
+static SparklineLayer* sparkline_layer;
+static ChartAnimator* chart_animator;
 static TextLayer * title_text_layer;
 static bool bToggleColors = true;
+static bool bCursorMode = false;
+static int iCursorPx = 0;
+static char cursor_text[32];
 
 static void load_chart_1() {
   const int x[] = { 50, 60, 80, 90, 100, 110 };
@@ -79,7 +84,81 @@ static void load_chart_7() {
   chart_layer_set_data(chart_layer, x, eFLOAT, y, eFLOAT, 6);
 }
 
-#define NUM_CHARTS 7
+static void load_chart_8() {
+  // recorded payload as sent from the phone:
+  // 14 heart rate samples, 5 seconds apart
+  static const uint8_t packed[] = {
+    0x01, 0x01, 0x00, 0x00, 0x0E, 0x00, 0x0A, 0x7C, 0x04, 0x06, 0x08,
+    0x0E, 0x22, 0x22, 0x0C, 0x1B, 0x1F, 0x17, 0x0B, 0x07, 0x03
+  };
+  chart_layer_ingest_packed(chart_layer, packed, sizeof(packed));
+}
+
+static void load_chart_9() {
+  // ~1000 samples kept in compressed blocks
+  chart_layer_set_history_capacity(chart_layer, 24);
+  chart_layer_set_autoscale(chart_layer, true, 0.1);
+  chart_layer_set_overlays(chart_layer, eSIMPLE_AVERAGE, false, 50);
+  int y = 50;
+  for (int i = 0; i < 1000; ++i) {
+    y += (i % 7) - 3 + ((i % 100) < 50 ? 1 : -1);
+    chart_layer_append_point(chart_layer, i * 60, y);
+  }
+}
+
+static void unload_chart_9() {
+  chart_layer_set_autoscale(chart_layer, false, 0);
+  chart_layer_set_overlays(chart_layer, eNO_AVERAGE, false, 0);
+  chart_layer_set_history_capacity(chart_layer, 0);
+}
+
+static void load_chart_10() {
+  chart_layer_set_plot_type(chart_layer, eHISTOGRAM);
+  int samples[300];
+  for (int i = 0; i < 300; ++i)
+    samples[i] = 60 + ((i * i * 7) % 41) + ((i % 13) * 3);
+  chart_layer_set_samples(chart_layer, samples, eINT, 300);
+}
+
+static void unload_chart_10() {
+  chart_layer_set_plot_type(chart_layer, eLINE);
+}
+
+static void load_chart_11() {
+  chart_layer_set_plot_type(chart_layer, eSTACKED_BAR);
+  // minutes of light, moderate, and vigorous activity per day
+  const int x[] = { 0, 1, 2, 3, 4, 5, 6 };
+  const int y[] = { 30, 10, 5,
+		    45, 20, 0,
+		    20, 15, 10,
+		    60, 5, 5,
+		    35, 25, 15,
+		    50, 30, 20,
+		    25, 10, 0 };
+  chart_layer_set_series_data(chart_layer, x, eINT, y, eINT, 7, 3);
+}
+
+static void unload_chart_11() {
+  chart_layer_set_plot_type(chart_layer, eLINE);
+}
+
+static void load_chart_12() {
+  // 500 points in a 256 byte budget, aggregated into 16 buckets
+  static int x[500];
+  static int y[500];
+  for (int i = 0; i < 500; ++i) {
+    x[i] = i;
+    y[i] = 50 + ((i * 37) % 23) - ((i / 50) % 2) * 15;
+  }
+  chart_layer_set_memory_budget(chart_layer, 256, 0);
+  chart_layer_set_data(chart_layer, x, eINT, y, eINT, 500);
+}
+
+static void unload_chart_12() {
+  chart_layer_set_memory_budget(chart_layer, 0, 0);
+}
+
+#define NUM_CHARTS 12
 typedef void (*funcLoad)();
 static funcLoad loadCallbacks[NUM_CHARTS] = { 
   &load_chart_1, 
@@ -88,7 +167,12 @@ static funcLoad loadCallbacks[NUM_CHARTS] = {
   &load_chart_4,
   &load_chart_5,
   &load_chart_6,
-  &load_chart_7
+  &load_chart_7,
+  &load_chart_8,
+  &load_chart_9,
+  &load_chart_10,
+  &load_chart_11,
+  &load_chart_12
 };
 typedef void (*funcUnload)();
 static funcUnload unloadCallbacks[NUM_CHARTS] = { 
@@ -98,7 +182,12 @@ static funcUnload unloadCallbacks[NUM_CHARTS] = {
   &unload_chart_4,
   &unload_chart_5,
   &unload_chart_6,
-  NULL
+  NULL,
+  NULL,
+  &unload_chart_9,
+  &unload_chart_10,
+  &unload_chart_11,
+  &unload_chart_12
 };
 static const char* chartTitles[NUM_CHARTS] = { 
   "Pinned X to 0",
@@ -107,7 +196,12 @@ static const char* chartTitles[NUM_CHARTS] = {
   "Scatter chart",
   "Bar chart",
   "Bar chart w/gap",
-  "Unsorted X"
+  "Unsorted X",
+  "Packed payload",
+  "Compressed history",
+  "Histogram",
+  "Stacked bars",
+  "Memory budget"
 };
 static int curr_chart = 0;
 
@@ -124,11 +218,13 @@ static void load_curr_chart() {
 static void select_click_handler(ClickRecognizerRef recognizer, void *context) {
   if (bToggleColors) {
     chart_layer_set_plot_color(chart_layer, GColorWhite);
+    chart_layer_set_overlay_color(chart_layer, GColorWhite);
     chart_layer_set_canvas_color(chart_layer, GColorBlack);
     chart_layer_show_frame(chart_layer, true);
   }
   else {
     chart_layer_set_plot_color(chart_layer, GColorBlack);
+    chart_layer_set_overlay_color(chart_layer, GColorBlack);
     chart_layer_set_canvas_color(chart_layer, GColorWhite);
     chart_layer_show_frame(chart_layer, false);
   }
@@ -136,7 +232,45 @@ static void select_click_handler(ClickRecognizerRef recognizer, void *context) {
   bToggleColors = !bToggleColors;
 }
 
+// steps the cursor by delta pixels, showing the value of the closest point
+static void move_cursor(int delta) {
+  GRect bounds = layer_get_bounds(chart_layer_get_layer(chart_layer));
+  iCursorPx += delta;
+  if (iCursorPx < 0)
+    iCursorPx = 0;
+  if (iCursorPx > bounds.size.w)
+    iCursorPx = bounds.size.w;
+
+  float x, y;
+  if (chart_layer_query_nearest(chart_layer, iCursorPx, &x, &y)) {
+    chart_layer_set_cursor(chart_layer, x);
+    snprintf(cursor_text, sizeof(cursor_text), "x: %d y: %d", (int)x, (int)y);
+    text_layer_set_text(text_layer, cursor_text);
+  }
+}
+
+static void click_config_provider(void *context);
+
+static void select_long_click_handler(ClickRecognizerRef recognizer, void *context) {
+  bCursorMode = !bCursorMode;
+  // up/down only repeat while they move the cursor
+  window_set_click_config_provider(window, click_config_provider);
+  if (bCursorMode) {
+    iCursorPx = layer_get_bounds(chart_layer_get_layer(chart_layer)).size.w / 2;
+    move_cursor(0);
+  }
+  else {
+    chart_layer_clear_cursor(chart_layer);
+    text_layer_set_text(text_layer, "Press Up/Down");
+  }
+}
+
 static void up_click_handler(ClickRecognizerRef recognizer, void *context) {
+  if (bCursorMode) {
+    move_cursor(-2);
+    return;
+  }
+
   unload_curr_chart();
   
   --curr_chart;
@@ -147,6 +281,11 @@ static void up_click_handler(ClickRecognizerRef recognizer, void *context) {
 }
 
 static void down_click_handler(ClickRecognizerRef recognizer, void *context) {
+  if (bCursorMode) {
+    move_cursor(2);
+    return;
+  }
+
   unload_curr_chart();
   
   ++curr_chart;
@@ -158,8 +297,15 @@ static void down_click_handler(ClickRecognizerRef recognizer, void *context) {
 
 static void click_config_provider(void *context) {
   window_single_click_subscribe(BUTTON_ID_SELECT, select_click_handler);
-  window_single_click_subscribe(BUTTON_ID_UP, up_click_handler);
-  window_single_click_subscribe(BUTTON_ID_DOWN, down_click_handler);
+  window_long_click_subscribe(BUTTON_ID_SELECT, 0, select_long_click_handler, NULL);
+  if (bCursorMode) {
+    window_single_repeating_click_subscribe(BUTTON_ID_UP, 100, up_click_handler);
+    window_single_repeating_click_subscribe(BUTTON_ID_DOWN, 100, down_click_handler);
+  }
+  else {
+    window_single_click_subscribe(BUTTON_ID_UP, up_click_handler);
+    window_single_click_subscribe(BUTTON_ID_DOWN, down_click_handler);
+  }
 }
 
 static void window_load(Window *window) {
@@ -175,11 +321,25 @@ static void window_load(Window *window) {
       .origin = { 0, 40},
 	.size = { bounds.size.w, 80 } });
   chart_layer_set_plot_color(chart_layer, GColorBlack);
+  chart_layer_set_overlay_color(chart_layer, GColorBlack);
   chart_layer_set_canvas_color(chart_layer, GColorWhite);
   chart_layer_show_points_on_line(chart_layer, true);
   //chart_layer_animate(chart_layer, false);
+  // switching charts moves the points instead of redrawing from scratch
+  chart_layer_set_morph(chart_layer, true);
+  // charts on a window can share one animation, redrawing the window once per frame
+  chart_animator = chart_animator_create(window_layer);
+  chart_layer_set_animator(chart_layer, chart_animator);
   layer_add_child(window_layer, chart_layer_get_layer(chart_layer));
 
+  // steps per hour over the last day
+  const int steps[] = { 0, 0, 0, 0, 0, 0, 120, 850, 1200, 400, 300, 650,
+			900, 350, 200, 250, 500, 1400, 800, 600, 300, 150, 50, 0 };
+  sparkline_layer = sparkline_layer_create((GRect) { .origin = { 10, 22 }, .size = { bounds.size.w - 20, 14 } });
+  sparkline_layer_set_color(sparkline_layer, GColorBlack);
+  sparkline_layer_set_data(sparkline_layer, steps, eINT, 24);
+  layer_add_child(window_layer, sparkline_layer_get_layer(sparkline_layer));
+
   title_text_layer = text_layer_create((GRect) { .origin = { 0, 140 }, .size = { bounds.size.w, 20 } });
   text_layer_set_text_alignment(title_text_layer, GTextAlignmentCenter);
   layer_add_child(window_layer, text_layer_get_layer(title_text_layer));
@@ -190,6 +350,8 @@ static void window_load(Window *window) {
 static void window_unload(Window *window) {
   text_layer_destroy(text_layer);
   chart_layer_destroy(chart_layer);
+  sparkline_layer_destroy(sparkline_layer);
+  chart_animator_destroy(chart_animator);
   text_layer_destroy(title_text_layer);
 }
 
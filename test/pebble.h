@@ -0,0 +1,184 @@
+#pragma once
+
+// Stand-in for the parts of the Pebble SDK used by pebble_chart.c, so
+// that the library can be built and tested natively (see Makefile).
+// Drawing through a GContext only counts the calls; rendering into a
+// GBitmap (chart_layer_render_to_bitmap) produces real pixels.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define PBL_SDK_3
+
+// allocations go through the stub, so that tests can make them fail
+// (see stub_set_malloc_limit)
+void* stub_malloc(size_t size);
+#define malloc(size) stub_malloc(size)
+
+///////////////////////////////////
+// graphics types
+
+typedef struct {
+  int16_t x;
+  int16_t y;
+} GPoint;
+
+typedef struct {
+  int16_t w;
+  int16_t h;
+} GSize;
+
+typedef struct {
+  GPoint origin;
+  GSize size;
+} GRect;
+
+typedef union {
+  uint8_t argb;
+} GColor8;
+typedef GColor8 GColor;
+
+#define GColorClear ((GColor8) { .argb = 0x00 })
+#define GColorBlack ((GColor8) { .argb = 0xC0 })
+#define GColorWhite ((GColor8) { .argb = 0xFF })
+
+typedef enum {
+  GCornerNone = 0,
+  GCornersAll = 0xF
+} GCornerMask;
+
+typedef enum {
+  GBitmapFormat1Bit = 0,
+  GBitmapFormat8Bit,
+  GBitmapFormat1BitPalette,
+  GBitmapFormat2BitPalette,
+  GBitmapFormat4BitPalette,
+  GBitmapFormat8BitCircular
+} GBitmapFormat;
+
+typedef struct GContext GContext;
+typedef struct GBitmap GBitmap;
+
+void graphics_context_set_fill_color(GContext* ctx, GColor color);
+void graphics_context_set_stroke_color(GContext* ctx, GColor color);
+void graphics_context_set_text_color(GContext* ctx, GColor color);
+void graphics_fill_rect(GContext* ctx, GRect rect, uint16_t corner_radius, GCornerMask corner_mask);
+void graphics_draw_rect(GContext* ctx, GRect rect);
+void graphics_draw_line(GContext* ctx, GPoint p0, GPoint p1);
+void graphics_fill_circle(GContext* ctx, GPoint p, uint16_t radius);
+void graphics_draw_pixel(GContext* ctx, GPoint point);
+
+GBitmap* gbitmap_create_blank(GSize size, GBitmapFormat format);
+void gbitmap_destroy(GBitmap* bitmap);
+uint8_t* gbitmap_get_data(const GBitmap* bitmap);
+uint16_t gbitmap_get_bytes_per_row(const GBitmap* bitmap);
+GBitmapFormat gbitmap_get_format(const GBitmap* bitmap);
+GRect gbitmap_get_bounds(const GBitmap* bitmap);
+
+///////////////////////////////////
+// layers
+
+typedef struct Layer Layer;
+typedef void (*LayerUpdateProc)(Layer* layer, GContext* ctx);
+
+Layer* layer_create(GRect frame);
+Layer* layer_create_with_data(GRect frame, size_t data_size);
+void layer_destroy(Layer* layer);
+void* layer_get_data(const Layer* layer);
+GRect layer_get_bounds(const Layer* layer);
+GRect layer_get_frame(const Layer* layer);
+void layer_set_frame(Layer* layer, GRect frame);
+void layer_set_update_proc(Layer* layer, LayerUpdateProc update_proc);
+void layer_mark_dirty(Layer* layer);
+void layer_add_child(Layer* parent, Layer* child);
+void layer_remove_from_parent(Layer* child);
+
+///////////////////////////////////
+// animations
+
+typedef struct Animation Animation;
+typedef uint32_t AnimationProgress;
+
+#define ANIMATION_NORMALIZED_MIN 0
+#define ANIMATION_NORMALIZED_MAX 65535
+
+typedef enum {
+  AnimationCurveLinear = 0
+} AnimationCurve;
+
+typedef void (*AnimationStartedHandler)(Animation* animation, void* context);
+typedef void (*AnimationStoppedHandler)(Animation* animation, bool finished, void* context);
+
+typedef struct {
+  AnimationStartedHandler started;
+  AnimationStoppedHandler stopped;
+} AnimationHandlers;
+
+typedef void (*AnimationSetupImplementation)(Animation* animation);
+typedef void (*AnimationUpdateImplementation)(Animation* animation, const AnimationProgress progress);
+typedef void (*AnimationTeardownImplementation)(Animation* animation);
+
+typedef struct AnimationImplementation {
+  AnimationSetupImplementation setup;
+  AnimationUpdateImplementation update;
+  AnimationTeardownImplementation teardown;
+} AnimationImplementation;
+
+Animation* animation_create(void);
+void animation_destroy(Animation* animation);
+bool animation_set_curve(Animation* animation, AnimationCurve curve);
+bool animation_set_handlers(Animation* animation, AnimationHandlers handlers, void* context);
+bool animation_set_implementation(Animation* animation, const AnimationImplementation* implementation);
+bool animation_set_duration(Animation* animation, uint32_t duration_ms);
+void* animation_get_context(Animation* animation);
+bool animation_schedule(Animation* animation);
+bool animation_unschedule(Animation* animation);
+bool animation_is_scheduled(Animation* animation);
+
+///////////////////////////////////
+// storage, time and memory
+
+#define PERSIST_DATA_MAX_LENGTH 256
+
+int persist_write_data(const uint32_t key, const void* data, const size_t size);
+int persist_read_data(const uint32_t key, void* buffer, const size_t buffer_size);
+bool persist_exists(const uint32_t key);
+int persist_delete(const uint32_t key);
+
+uint16_t time_ms(time_t* t_utc, uint16_t* out_ms);
+size_t heap_bytes_free(void);
+
+#define APP_LOG(level, ...) ((void)0)
+#define APP_LOG_LEVEL_DEBUG 0
+
+///////////////////////////////////
+// test hooks, not part of the SDK
+
+// counts the drawing calls made through it
+struct GContext {
+  unsigned int iNumCalls;
+  GPoint lastPoint; // end of the last line or pixel drawn
+};
+
+// calls the layer's update proc, as a redraw of the screen would
+void stub_layer_draw(Layer* layer, GContext* ctx);
+
+// number of times the layer was marked dirty
+unsigned int stub_layer_dirty_count(const Layer* layer);
+
+// runs a scheduled animation to its end
+void stub_animation_finish(Animation* animation);
+
+// number of animations which currently exist
+int stub_animation_count(void);
+
+void stub_set_time_ms(const uint32_t iTime);
+void stub_set_heap_bytes_free(const size_t iBytes);
+
+// makes allocations of more than iBytes fail, SIZE_MAX allows all of them
+void stub_set_malloc_limit(const size_t iBytes);
+void stub_persist_clear(void);
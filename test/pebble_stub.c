@@ -0,0 +1,348 @@
+#include <pebble.h>
+
+///////////////////////////////////
+// graphics
+
+// drawing through a context isn't rendered, only counted
+static void stub_count_call(GContext* ctx) {
+  if (ctx)
+    ++ctx->iNumCalls;
+}
+
+void graphics_context_set_fill_color(GContext* ctx, GColor color) {
+}
+
+void graphics_context_set_stroke_color(GContext* ctx, GColor color) {
+}
+
+void graphics_context_set_text_color(GContext* ctx, GColor color) {
+}
+
+void graphics_fill_rect(GContext* ctx, GRect rect, uint16_t corner_radius, GCornerMask corner_mask) {
+  stub_count_call(ctx);
+}
+
+void graphics_draw_rect(GContext* ctx, GRect rect) {
+  stub_count_call(ctx);
+}
+
+void graphics_draw_line(GContext* ctx, GPoint p0, GPoint p1) {
+  stub_count_call(ctx);
+  if (ctx)
+    ctx->lastPoint = p1;
+}
+
+void graphics_fill_circle(GContext* ctx, GPoint p, uint16_t radius) {
+  stub_count_call(ctx);
+}
+
+void graphics_draw_pixel(GContext* ctx, GPoint point) {
+  stub_count_call(ctx);
+  if (ctx)
+    ctx->lastPoint = point;
+}
+
+struct GBitmap {
+  GSize size;
+  GBitmapFormat format;
+  uint16_t iRowBytes;
+  uint8_t* pData;
+};
+
+GBitmap* gbitmap_create_blank(GSize size, GBitmapFormat format) {
+  GBitmap* bitmap = (GBitmap*)calloc(1, sizeof(GBitmap));
+  if (!bitmap)
+    return NULL;
+  bitmap->size = size;
+  bitmap->format = format;
+  // 1-bit rows are padded to whole words, as on the watch; other formats
+  // get a byte per pixel, which is enough for all of them
+  bitmap->iRowBytes = (format == GBitmapFormat1Bit) ? (((size.w + 31) / 32) * 4) : size.w;
+  bitmap->pData = (uint8_t*)calloc(bitmap->iRowBytes, size.h);
+  if (!bitmap->pData) {
+    free(bitmap);
+    return NULL;
+  }
+  return bitmap;
+}
+
+void gbitmap_destroy(GBitmap* bitmap) {
+  if (bitmap) {
+    free(bitmap->pData);
+    free(bitmap);
+  }
+}
+
+uint8_t* gbitmap_get_data(const GBitmap* bitmap) {
+  return bitmap->pData;
+}
+
+uint16_t gbitmap_get_bytes_per_row(const GBitmap* bitmap) {
+  return bitmap->iRowBytes;
+}
+
+GBitmapFormat gbitmap_get_format(const GBitmap* bitmap) {
+  return bitmap->format;
+}
+
+GRect gbitmap_get_bounds(const GBitmap* bitmap) {
+  return (GRect) { .origin = { 0, 0 }, .size = bitmap->size };
+}
+
+///////////////////////////////////
+// layers
+
+struct Layer {
+  GRect frame;
+  void* pData;
+  LayerUpdateProc update_proc;
+  Layer* pParent;
+  unsigned int iDirtyCount;
+};
+
+Layer* layer_create(GRect frame) {
+  return layer_create_with_data(frame, 0);
+}
+
+Layer* layer_create_with_data(GRect frame, size_t data_size) {
+  Layer* layer = (Layer*)calloc(1, sizeof(Layer));
+  if (!layer)
+    return NULL;
+  layer->frame = frame;
+  if (data_size) {
+    // the watch doesn't clear the data either, so fill it with garbage
+    layer->pData = malloc(data_size);
+    if (!layer->pData) {
+      free(layer);
+      return NULL;
+    }
+    memset(layer->pData, 0xA5, data_size);
+  }
+  return layer;
+}
+
+void layer_destroy(Layer* layer) {
+  if (layer) {
+    free(layer->pData);
+    free(layer);
+  }
+}
+
+void* layer_get_data(const Layer* layer) {
+  return layer->pData;
+}
+
+GRect layer_get_bounds(const Layer* layer) {
+  return (GRect) { .origin = { 0, 0 }, .size = layer->frame.size };
+}
+
+GRect layer_get_frame(const Layer* layer) {
+  return layer->frame;
+}
+
+void layer_set_frame(Layer* layer, GRect frame) {
+  layer->frame = frame;
+}
+
+void layer_set_update_proc(Layer* layer, LayerUpdateProc update_proc) {
+  layer->update_proc = update_proc;
+}
+
+void layer_mark_dirty(Layer* layer) {
+  ++layer->iDirtyCount;
+}
+
+void layer_add_child(Layer* parent, Layer* child) {
+  child->pParent = parent;
+}
+
+void layer_remove_from_parent(Layer* child) {
+  child->pParent = NULL;
+}
+
+void stub_layer_draw(Layer* layer, GContext* ctx) {
+  if (layer->update_proc)
+    layer->update_proc(layer, ctx);
+}
+
+unsigned int stub_layer_dirty_count(const Layer* layer) {
+  return layer->iDirtyCount;
+}
+
+///////////////////////////////////
+// animations
+
+struct Animation {
+  AnimationHandlers handlers;
+  void* pContext;
+  const AnimationImplementation* pImplementation;
+  uint32_t iDuration;
+  bool bScheduled;
+};
+
+static int s_iNumAnimations = 0;
+
+Animation* animation_create(void) {
+  Animation* animation = (Animation*)calloc(1, sizeof(Animation));
+  if (animation)
+    ++s_iNumAnimations;
+  return animation;
+}
+
+void animation_destroy(Animation* animation) {
+  if (animation) {
+    animation_unschedule(animation);
+    --s_iNumAnimations;
+    free(animation);
+  }
+}
+
+bool animation_set_curve(Animation* animation, AnimationCurve curve) {
+  return true;
+}
+
+bool animation_set_handlers(Animation* animation, AnimationHandlers handlers, void* context) {
+  animation->handlers = handlers;
+  animation->pContext = context;
+  return true;
+}
+
+bool animation_set_implementation(Animation* animation, const AnimationImplementation* implementation) {
+  animation->pImplementation = implementation;
+  return true;
+}
+
+bool animation_set_duration(Animation* animation, uint32_t duration_ms) {
+  animation->iDuration = duration_ms;
+  return true;
+}
+
+void* animation_get_context(Animation* animation) {
+  return animation->pContext;
+}
+
+bool animation_schedule(Animation* animation) {
+  animation->bScheduled = true;
+  if (animation->handlers.started)
+    animation->handlers.started(animation, animation->pContext);
+  return true;
+}
+
+bool animation_unschedule(Animation* animation) {
+  if (!animation->bScheduled)
+    return false;
+  animation->bScheduled = false;
+  if (animation->handlers.stopped)
+    animation->handlers.stopped(animation, false, animation->pContext);
+  return true;
+}
+
+bool animation_is_scheduled(Animation* animation) {
+  return animation && animation->bScheduled;
+}
+
+void stub_animation_finish(Animation* animation) {
+  if (!animation_is_scheduled(animation))
+    return;
+  if (animation->pImplementation && animation->pImplementation->update)
+    animation->pImplementation->update(animation, ANIMATION_NORMALIZED_MAX);
+  animation->bScheduled = false;
+  if (animation->handlers.stopped)
+    animation->handlers.stopped(animation, true, animation->pContext);
+}
+
+int stub_animation_count(void) {
+  return s_iNumAnimations;
+}
+
+///////////////////////////////////
+// storage, time and memory
+
+#define STUB_PERSIST_MAX_KEYS 64
+
+static struct {
+  uint32_t iKey;
+  size_t iSize;
+  uint8_t aData[PERSIST_DATA_MAX_LENGTH];
+} s_aPersist[STUB_PERSIST_MAX_KEYS];
+static unsigned int s_iNumPersist = 0;
+
+static int stub_persist_find(const uint32_t key) {
+  for (unsigned int i = 0; i < s_iNumPersist; ++i) {
+    if (s_aPersist[i].iKey == key)
+      return (int)i;
+  }
+  return -1;
+}
+
+int persist_write_data(const uint32_t key, const void* data, const size_t size) {
+  int i = stub_persist_find(key);
+  if (i < 0) {
+    if (s_iNumPersist == STUB_PERSIST_MAX_KEYS)
+      return -1;
+    i = (int)s_iNumPersist++;
+    s_aPersist[i].iKey = key;
+  }
+  const size_t iSize = (size < PERSIST_DATA_MAX_LENGTH) ? size : PERSIST_DATA_MAX_LENGTH;
+  memcpy(s_aPersist[i].aData, data, iSize);
+  s_aPersist[i].iSize = iSize;
+  return (int)iSize;
+}
+
+int persist_read_data(const uint32_t key, void* buffer, const size_t buffer_size) {
+  const int i = stub_persist_find(key);
+  if (i < 0)
+    return -1;
+  const size_t iSize = (buffer_size < s_aPersist[i].iSize) ? buffer_size : s_aPersist[i].iSize;
+  memcpy(buffer, s_aPersist[i].aData, iSize);
+  return (int)iSize;
+}
+
+bool persist_exists(const uint32_t key) {
+  return stub_persist_find(key) >= 0;
+}
+
+int persist_delete(const uint32_t key) {
+  const int i = stub_persist_find(key);
+  if (i < 0)
+    return -1;
+  s_aPersist[i] = s_aPersist[--s_iNumPersist];
+  return 0;
+}
+
+void stub_persist_clear(void) {
+  s_iNumPersist = 0;
+}
+
+static uint32_t s_iTimeMs = 0;
+static size_t s_iHeapBytesFree = 64 * 1024;
+static size_t s_iMallocLimit = SIZE_MAX;
+
+#undef malloc
+void* stub_malloc(size_t size) {
+  return (size > s_iMallocLimit) ? NULL : malloc(size);
+}
+
+uint16_t time_ms(time_t* t_utc, uint16_t* out_ms) {
+  if (t_utc)
+    *t_utc = (time_t)(s_iTimeMs / 1000);
+  if (out_ms)
+    *out_ms = (uint16_t)(s_iTimeMs % 1000);
+  return (uint16_t)(s_iTimeMs % 1000);
+}
+
+size_t heap_bytes_free(void) {
+  return s_iHeapBytesFree;
+}
+
+void stub_set_time_ms(const uint32_t iTime) {
+  s_iTimeMs = iTime;
+}
+
+void stub_set_heap_bytes_free(const size_t iBytes) {
+  s_iHeapBytesFree = iBytes;
+}
+
+void stub_set_malloc_limit(const size_t iBytes) {
+  s_iMallocLimit = iBytes;
+}
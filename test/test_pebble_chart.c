@@ -0,0 +1,1190 @@
+// Native tests of the chart library, built against the stand-in for the
+// Pebble SDK in pebble.h (see Makefile). The library is included directly,
+// so that the tests can check its internal state.
+//
+//   test_pebble_chart                  runs the tests
+//   test_pebble_chart --update-golden  rewrites the golden images
+//   test_pebble_chart --bench          times layout and rendering
+
+#include "../src/pebble_chart.c"
+
+#include <stdio.h>
+
+#ifndef GOLDEN_DIR
+#define GOLDEN_DIR "golden"
+#endif
+#ifndef OUTPUT_DIR
+#define OUTPUT_DIR "."
+#endif
+
+static int s_iNumChecks = 0;
+static int s_iNumFailed = 0;
+static bool s_bUpdateGolden = false;
+
+#define CHECK(cond)							\
+  do {									\
+    ++s_iNumChecks;							\
+    if (!(cond)) {							\
+      ++s_iNumFailed;							\
+      printf("%s:%d: %s: check failed: %s\n", __FILE__, __LINE__, __func__, #cond); \
+    }									\
+  } while (0)
+
+///////////////////////////////////
+// helpers
+
+// deterministic wavy test data
+static void make_data(int* pX, int* pY, const unsigned int iNumPoints) {
+  for (unsigned int i = 0; i < iNumPoints; ++i) {
+    pX[i] = (int)i;
+    pY[i] = (int)((i * 37) % 101) - 50 + (int)(i / 4);
+  }
+}
+
+// a chart as the tests draw it: no animation, a margin of 2 pixels
+static ChartLayer* create_chart(const int iWidth, const int iHeight) {
+  ChartLayer* layer = chart_layer_create((GRect) { .origin = { 0, 0 }, .size = { iWidth, iHeight } });
+  chart_layer_animate(layer, false);
+  chart_layer_set_margin(layer, 2);
+  return layer;
+}
+
+// returns true for white pixels of a 1-bit bitmap
+static bool pixel_is_white(GBitmap* bitmap, const int x, const int y) {
+  const uint8_t* pRow = gbitmap_get_data(bitmap) + (y * gbitmap_get_bytes_per_row(bitmap));
+  return (pRow[x >> 3] >> (x & 7)) & 1;
+}
+
+// the bitmap as a plain PBM image, which has 1 for black pixels
+// returns the length of the image, or 0 if it doesn't fit in iSize
+static size_t format_pbm(GBitmap* bitmap, char* pBuffer, const size_t iSize) {
+  const GRect bounds = gbitmap_get_bounds(bitmap);
+  int iLength = snprintf(pBuffer, iSize, "P1\n%d %d\n", bounds.size.w, bounds.size.h);
+  if ((iLength < 0) || ((size_t)iLength + ((bounds.size.w + 1) * bounds.size.h) >= iSize))
+    return 0;
+  for (int y = 0; y < bounds.size.h; ++y) {
+    for (int x = 0; x < bounds.size.w; ++x)
+      pBuffer[iLength++] = pixel_is_white(bitmap, x, y) ? '0' : '1';
+    pBuffer[iLength++] = '\n';
+  }
+  pBuffer[iLength] = '\0';
+  return (size_t)iLength;
+}
+
+static bool write_file(const char* pPath, const char* pContents, const size_t iLength) {
+  FILE* pFile = fopen(pPath, "wb");
+  if (!pFile)
+    return false;
+  const bool bWritten = (fwrite(pContents, 1, iLength, pFile) == iLength);
+  return (fclose(pFile) == 0) && bWritten;
+}
+
+// compares a 1-bit bitmap with GOLDEN_DIR/<name>.pbm
+// a mismatch is written to OUTPUT_DIR/<name>.pbm for inspection
+static bool matches_golden(GBitmap* bitmap, const char* pName) {
+  static char s_aImage[16 * 1024];
+  static char s_aGolden[16 * 1024];
+  char aPath[256];
+  const size_t iLength = format_pbm(bitmap, s_aImage, sizeof(s_aImage));
+  if (!iLength)
+    return false;
+
+  snprintf(aPath, sizeof(aPath), "%s/%s.pbm", GOLDEN_DIR, pName);
+  if (s_bUpdateGolden)
+    return write_file(aPath, s_aImage, iLength);
+
+  size_t iGoldenLength = 0;
+  FILE* pFile = fopen(aPath, "rb");
+  if (pFile) {
+    iGoldenLength = fread(s_aGolden, 1, sizeof(s_aGolden), pFile);
+    fclose(pFile);
+  }
+  if ((iGoldenLength == iLength) && !memcmp(s_aGolden, s_aImage, iLength))
+    return true;
+
+  snprintf(aPath, sizeof(aPath), "%s/%s.pbm", OUTPUT_DIR, pName);
+  write_file(aPath, s_aImage, iLength);
+  printf("%s differs from %s/%s.pbm\n", aPath, GOLDEN_DIR, pName);
+  return false;
+}
+
+///////////////////////////////////
+// rendering
+
+static void test_render_line(void) {
+  int x[40], y[40];
+  make_data(x, y, 40);
+  ChartLayer* layer = create_chart(60, 40);
+  chart_layer_show_points_on_line(layer, true);
+  chart_layer_show_frame(layer, true);
+  chart_layer_set_data(layer, x, eINT, y, eINT, 12);
+  GBitmap* bitmap = gbitmap_create_blank((GSize) { 60, 40 }, GBitmapFormat1Bit);
+  CHECK(chart_layer_render_to_bitmap(layer, bitmap));
+  CHECK(matches_golden(bitmap, "line"));
+  gbitmap_destroy(bitmap);
+  chart_layer_destroy(layer);
+}
+
+static void test_render_bar(void) {
+  int x[40], y[40];
+  make_data(x, y, 40);
+  ChartLayer* layer = create_chart(60, 40);
+  chart_layer_set_plot_type(layer, eBAR);
+  chart_layer_set_canvas_color(layer, GColorWhite);
+  chart_layer_set_plot_color(layer, GColorBlack);
+  chart_layer_set_data(layer, x, eINT, y, eINT, 8);
+  GBitmap* bitmap = gbitmap_create_blank((GSize) { 60, 40 }, GBitmapFormat1Bit);
+  CHECK(chart_layer_render_to_bitmap(layer, bitmap));
+  CHECK(matches_golden(bitmap, "bar"));
+  gbitmap_destroy(bitmap);
+  chart_layer_destroy(layer);
+}
+
+static void test_render_scatter(void) {
+  int x[40], y[40];
+  make_data(x, y, 40);
+  ChartLayer* layer = create_chart(60, 40);
+  chart_layer_set_plot_type(layer, eSCATTER);
+  chart_layer_set_data(layer, x, eINT, y, eINT, 40);
+  GBitmap* bitmap = gbitmap_create_blank((GSize) { 60, 40 }, GBitmapFormat1Bit);
+  CHECK(chart_layer_render_to_bitmap(layer, bitmap));
+  CHECK(matches_golden(bitmap, "scatter"));
+  gbitmap_destroy(bitmap);
+  chart_layer_destroy(layer);
+}
+
+// 8-bit bitmaps get the same pixels as 1-bit ones, in the chart's colors
+static void test_render_8bit(void) {
+  int x[40], y[40];
+  make_data(x, y, 40);
+  ChartLayer* layer = create_chart(60, 40);
+  chart_layer_set_data(layer, x, eINT, y, eINT, 40);
+  GBitmap* bitmap1 = gbitmap_create_blank((GSize) { 60, 40 }, GBitmapFormat1Bit);
+  GBitmap* bitmap8 = gbitmap_create_blank((GSize) { 60, 40 }, GBitmapFormat8Bit);
+  CHECK(chart_layer_render_to_bitmap(layer, bitmap1));
+  CHECK(chart_layer_render_to_bitmap(layer, bitmap8));
+  int iMismatches = 0;
+  for (int y = 0; y < 39; ++y) {
+    for (int x = 0; x < 59; ++x) {
+      const uint8_t iPixel = gbitmap_get_data(bitmap8)[(y * gbitmap_get_bytes_per_row(bitmap8)) + x];
+      if (iPixel != (pixel_is_white(bitmap1, x, y) ? GColorWhite.argb : GColorBlack.argb))
+	++iMismatches;
+    }
+  }
+  CHECK(iMismatches == 0);
+  gbitmap_destroy(bitmap1);
+  gbitmap_destroy(bitmap8);
+  chart_layer_destroy(layer);
+}
+
+// a bitmap smaller than the chart gets the top left of the chart
+static void test_render_clipped(void) {
+  int x[40], y[40];
+  make_data(x, y, 40);
+  ChartLayer* layer = create_chart(60, 40);
+  chart_layer_show_frame(layer, true);
+  chart_layer_set_data(layer, x, eINT, y, eINT, 40);
+  GBitmap* full = gbitmap_create_blank((GSize) { 60, 40 }, GBitmapFormat1Bit);
+  GBitmap* part = gbitmap_create_blank((GSize) { 21, 9 }, GBitmapFormat1Bit);
+  CHECK(chart_layer_render_to_bitmap(layer, full));
+  CHECK(chart_layer_render_to_bitmap(layer, part));
+  int iMismatches = 0;
+  for (int y = 0; y < 9; ++y) {
+    for (int x = 0; x < 21; ++x) {
+      if (pixel_is_white(full, x, y) != pixel_is_white(part, x, y))
+	++iMismatches;
+    }
+  }
+  CHECK(iMismatches == 0);
+  gbitmap_destroy(full);
+  gbitmap_destroy(part);
+  chart_layer_destroy(layer);
+}
+
+// rendering draws the whole chart, finishing its animation on screen
+static void test_render_finishes_animation(void) {
+  int x[40], y[40];
+  make_data(x, y, 40);
+  ChartLayer* layer = create_chart(60, 40);
+  chart_layer_animate(layer, true);
+  chart_layer_set_data(layer, x, eINT, y, eINT, 40);
+  GContext ctx = { 0 };
+  stub_layer_draw(chart_layer_get_layer(layer), &ctx);
+  ChartLayerData* pData = get_chart_data(layer);
+  CHECK(chart_layer_is_animating(pData));
+  CHECK(pData->iPointsToDraw < pData->iNumPoints);
+
+  GBitmap* bitmap = gbitmap_create_blank((GSize) { 60, 40 }, GBitmapFormat1Bit);
+  CHECK(chart_layer_render_to_bitmap(layer, bitmap));
+  CHECK(!chart_layer_is_animating(pData));
+  CHECK(pData->iPointsToDraw == pData->iNumPoints);
+  gbitmap_destroy(bitmap);
+  chart_layer_destroy(layer);
+}
+
+// formats that the rasterizer can't write are refused, as are missing arguments
+static void test_render_unsupported(void) {
+  ChartLayer* layer = create_chart(60, 40);
+  GBitmap* valid = gbitmap_create_blank((GSize) { 60, 40 }, GBitmapFormat1Bit);
+  CHECK(!chart_layer_render_to_bitmap(NULL, valid));
+  CHECK(!chart_layer_render_to_bitmap(layer, NULL));
+  gbitmap_destroy(valid);
+  GBitmap* bitmap = gbitmap_create_blank((GSize) { 60, 40 }, GBitmapFormat2BitPalette);
+  CHECK(!chart_layer_render_to_bitmap(layer, bitmap));
+  gbitmap_destroy(bitmap);
+  chart_layer_destroy(layer);
+}
+
+///////////////////////////////////
+// creation and appending
+
+// the layout cache starts out empty, whatever the memory held before
+static void test_create_initializes_layout(void) {
+  ChartLayer* layer = create_chart(60, 40);
+  ChartLayerData* pData = get_chart_data(layer);
+  CHECK((pData->fXScale == 0) && (pData->fYScale == 0) && (pData->fLayoutXSep == 0));
+  CHECK((pData->fLayoutXMin == 0) && (pData->fLayoutXMax == 0));
+  CHECK((pData->fLayoutYMin == 0) && (pData->fLayoutYMax == 0));
+  CHECK((pData->iSampling == 0) && (pData->iNumSampled == 0) && (pData->iBarWidth == 0));
+  CHECK((pData->iPointCapacity == 0) && (pData->iYTicks == 0));
+  chart_layer_destroy(layer);
+}
+
+// appending without a sampled layout relayouts instead of mapping the point
+static void test_append_without_sampling(void) {
+  ChartLayer* layer = create_chart(60, 40);
+  CHECK(chart_layer_set_history_capacity(layer, 4));
+  for (int i = 0; i < 10; ++i)
+    CHECK(chart_layer_append_point(layer, i, i % 3));
+  chart_layer_update_layout(layer);
+  ChartLayerData* pData = get_chart_data(layer);
+  CHECK(!pData->bLayoutDirty && (pData->iSampling > 0));
+
+  pData->iSampling = 0;
+  CHECK(!chart_layer_append_to_layout(layer, 5, 1));
+  CHECK(chart_layer_append_point(layer, 11, 1));
+  CHECK(pData->bLayoutDirty);
+  chart_layer_destroy(layer);
+}
+
+///////////////////////////////////
+// packed data
+
+// true if the values differ by at most a millionth of their size
+static bool close_to(const float a, const float b) {
+  const float d = (a < b) ? b - a : a - b;
+  const float m = (a < 0) ? -a : a;
+  return d <= (m + 1) * 1e-6f;
+}
+
+// true if the chart holds the given points
+static bool holds_points(ChartLayer* layer, const float* pX, const float* pY, const unsigned int iNumPoints) {
+  ChartLayerData* pData = get_chart_data(layer);
+  if (pData->iNumOrigPoints != iNumPoints)
+    return false;
+  for (unsigned int i = 0; i < iNumPoints; ++i) {
+    if (!close_to(pData->pXOrigData[i], pX[i]) || !close_to(pData->pYOrigData[i], pY[i]))
+      return false;
+  }
+  return true;
+}
+
+// payloads as sent by the phone decode to their samples
+static void test_ingest_packed(void) {
+  // evenly spaced from 10 by 5, y-values with 1 decimal place
+  const uint8_t aUniform[] = { CHART_PACKED_VERSION, CHART_PACKED_UNIFORM_X, 0, 1, 3,
+			       0x14, 0x0A,
+			       0x32, 0x09, 0xD8, 0x04 };
+  const float aUniformX[] = { 10, 15, 20 };
+  const float aUniformY[] = { 2.5, 2, 32 };
+  // x-values with 2 decimal places
+  const uint8_t aDeltas[] = { CHART_PACKED_VERSION, 0, 2, 0, 2,
+			      0xAC, 0x02, 0x05,
+			      0x32, 0x0E };
+  const float aDeltasX[] = { 1.5, 1.75 };
+  const float aDeltasY[] = { -3, 4 };
+
+  ChartLayer* layer = create_chart(60, 40);
+  CHECK(chart_layer_ingest_packed(layer, aUniform, sizeof(aUniform)));
+  CHECK(holds_points(layer, aUniformX, aUniformY, 3));
+  CHECK(chart_layer_ingest_packed(layer, aDeltas, sizeof(aDeltas)));
+  CHECK(holds_points(layer, aDeltasX, aDeltasY, 2));
+  GContext ctx = { 0 };
+  stub_layer_draw(chart_layer_get_layer(layer), &ctx);
+  CHECK(get_chart_data(layer)->iNumPoints == 2);
+  chart_layer_destroy(layer);
+}
+
+// malformed payloads leave the chart without data
+static void test_ingest_packed_malformed(void) {
+  const uint8_t aWrongVersion[] = { CHART_PACKED_VERSION + 1, 0, 0, 0, 1, 0x02, 0x02 };
+  const uint8_t aTruncated[] = { CHART_PACKED_VERSION, 0, 0, 0, 2, 0x02, 0x02, 0x02 };
+  const uint8_t aUnterminated[] = { CHART_PACKED_VERSION, 0, 0, 0, 1, 0x82, 0x82 };
+  const uint8_t aTooMany[] = { CHART_PACKED_VERSION, CHART_PACKED_UNIFORM_X, 0, 0, 0xFF, 0xFF, 0x0F, 0, 0, 0 };
+  const struct {
+    const uint8_t* pPacked;
+    size_t iLength;
+  } aPayloads[] = {
+    { aWrongVersion, sizeof(aWrongVersion) },
+    { aTruncated, sizeof(aTruncated) },
+    { aUnterminated, sizeof(aUnterminated) },
+    { aTooMany, sizeof(aTooMany) },
+    { aTruncated, 3 },
+    { NULL, 10 }
+  };
+  int x[10], y[10];
+  make_data(x, y, 10);
+  for (unsigned int i = 0; i < sizeof(aPayloads) / sizeof(aPayloads[0]); ++i) {
+    ChartLayer* layer = create_chart(60, 40);
+    chart_layer_set_data(layer, x, eINT, y, eINT, 10);
+    CHECK(!chart_layer_ingest_packed(layer, aPayloads[i].pPacked, aPayloads[i].iLength));
+    CHECK(get_chart_data(layer)->iNumOrigPoints == 0);
+    chart_layer_destroy(layer);
+  }
+}
+
+// deltas which overflow the values wrap around instead
+static void test_ingest_packed_overflow(void) {
+  const uint8_t aPacked[] = { CHART_PACKED_VERSION, 0, 0, 0, 3,
+			      0xFE, 0xFF, 0xFF, 0xFF, 0x0F, 0xFE, 0xFF, 0xFF, 0xFF, 0x0F,
+			      0xFE, 0xFF, 0xFF, 0xFF, 0x0F, 0xFE, 0xFF, 0xFF, 0xFF, 0x0F,
+			      0xFE, 0xFF, 0xFF, 0xFF, 0x0F, 0xFE, 0xFF, 0xFF, 0xFF, 0x0F };
+  ChartLayer* layer = create_chart(60, 40);
+  CHECK(chart_layer_ingest_packed(layer, aPacked, sizeof(aPacked)));
+  CHECK(get_chart_data(layer)->iNumOrigPoints == 3);
+  CHECK(close_to(get_chart_data(layer)->pXOrigData[2], INT32_MAX - 2));
+  chart_layer_destroy(layer);
+}
+
+///////////////////////////////////
+// autoscaling
+
+// sets y-values from iMin to iMax, in steps of 10
+static void set_range_data(ChartLayer* layer, const int iMin, const int iMax) {
+  int x[64], y[64];
+  unsigned int iNumPoints = 0;
+  for (int v = iMin; (v <= iMax) && (iNumPoints < 64); v += 10, ++iNumPoints) {
+    x[iNumPoints] = (int)iNumPoints;
+    y[iNumPoints] = v;
+  }
+  chart_layer_set_data(layer, x, eINT, y, eINT, iNumPoints);
+  chart_layer_update_layout(layer);
+}
+
+// new data keeps the autoscaled range, until the autoscaling is set again
+static void test_autoscale_kept_across_data(void) {
+  ChartLayer* layer = create_chart(60, 40);
+  ChartLayerData* pData = get_chart_data(layer);
+  chart_layer_set_autoscale(layer, true, 0);
+  set_range_data(layer, 0, 100);
+  CHECK((pData->fAutoYMin == 0) && (pData->fAutoYMax == 100));
+  set_range_data(layer, 0, 60);
+  CHECK((pData->fAutoYMin == 0) && (pData->fAutoYMax == 100));
+
+  chart_layer_set_autoscale(layer, true, 0);
+  chart_layer_update_layout(layer);
+  CHECK((pData->fAutoYMin == 0) && (pData->fAutoYMax == 60));
+  chart_layer_destroy(layer);
+}
+
+// data which still fits leaves the range unchanged
+static void test_autoscale_fitting_data(void) {
+  ChartLayer* layer = create_chart(60, 40);
+  ChartLayerData* pData = get_chart_data(layer);
+  chart_layer_set_autoscale(layer, true, 0.1);
+  set_range_data(layer, 0, 100);
+  CHECK((pData->fAutoYMin == -20) && (pData->fAutoYMax == 120));
+  set_range_data(layer, 0, 80);
+  CHECK((pData->fAutoYMin == -20) && (pData->fAutoYMax == 120));
+  set_range_data(layer, 0, 100);
+  CHECK((pData->fAutoYMin == -20) && (pData->fAutoYMax == 120));
+  set_range_data(layer, 0, 130);
+  CHECK(pData->fAutoYMax >= 130);
+  chart_layer_destroy(layer);
+}
+
+// a new range is always kept for the data it was chosen for
+static void test_autoscale_new_range_is_kept(void) {
+  const float aHeadroom[] = { 0, 0.05, 0.1, 0.25, 0.5, 1 };
+  int iFailures = 0;
+  for (unsigned int h = 0; h < sizeof(aHeadroom) / sizeof(aHeadroom[0]); ++h) {
+    for (int i = 1; i < 2000; i += 7) {
+      for (unsigned int bPadMin = 0; bPadMin < 2; ++bPadMin) {
+	const float fDataMin = (float)((i * 13) % 200) - 100;
+	const float fDataMax = fDataMin + (float)i / 8;
+	float fAutoMin = NOT_SET, fAutoMax = NOT_SET;
+	float fMin = fDataMin, fMax = fDataMax;
+	autoscale_axis(aHeadroom[h], bPadMin, &fMin, &fMax, &fAutoMin, &fAutoMax);
+	const float fFreshMin = fAutoMin, fFreshMax = fAutoMax;
+	fMin = fDataMin;
+	fMax = fDataMax;
+	autoscale_axis(aHeadroom[h], bPadMin, &fMin, &fMax, &fAutoMin, &fAutoMax);
+	// the data with its headroom fills at least half of the range
+	const float fPadded = (fDataMax - fDataMin) * (1 + ((bPadMin ? 2 : 1) * aHeadroom[h]));
+	if ((fFreshMin > fDataMin) || (fFreshMax < fDataMax) || ((fFreshMax - fFreshMin) > (2 * fPadded)) ||
+	    (fAutoMin != fFreshMin) || (fAutoMax != fFreshMax))
+	  ++iFailures;
+      }
+    }
+  }
+  CHECK(iFailures == 0);
+}
+
+///////////////////////////////////
+// constant data
+
+// data without any spread in y still gets a finite scale, with the values
+// in the middle of the plot
+static void test_constant_data(void) {
+  const ChartPlotType aTypes[] = { eLINE, eSCATTER, eBAR, eHISTOGRAM, eSTACKED_BAR };
+  const int aValues[] = { 0, 7, -250, 100000 };
+  for (unsigned int t = 0; t < sizeof(aTypes) / sizeof(aTypes[0]); ++t) {
+    for (unsigned int v = 0; v < sizeof(aValues) / sizeof(aValues[0]); ++v) {
+      for (unsigned int bAutoscale = 0; bAutoscale < 2; ++bAutoscale) {
+	int x[10], y[10];
+	for (int i = 0; i < 10; ++i) {
+	  x[i] = i;
+	  y[i] = aValues[v];
+	}
+	ChartLayer* layer = create_chart(60, 40);
+	chart_layer_set_plot_type(layer, aTypes[t]);
+	chart_layer_set_autoscale(layer, bAutoscale, 0.1);
+	if (aTypes[t] == eSTACKED_BAR)
+	  chart_layer_set_series_data(layer, x, eINT, y, eINT, 10, 1);
+	else
+	  chart_layer_set_data(layer, x, eINT, y, eINT, 10);
+	GBitmap* bitmap = gbitmap_create_blank((GSize) { 60, 40 }, GBitmapFormat1Bit);
+	CHECK(chart_layer_render_to_bitmap(layer, bitmap));
+	ChartLayerData* pData = get_chart_data(layer);
+	CHECK((pData->fYScale > 0) && (pData->fYScale < 1e30f));
+	CHECK((pData->iYTicks >= 1) && (pData->iYTicks <= 40));
+	if ((aTypes[t] != eSTACKED_BAR) && (aTypes[t] != eHISTOGRAM)) {
+	  const int iMiddle = chart_layer_map_y(pData, layer_get_bounds(chart_layer_get_layer(layer)), aValues[v]);
+	  CHECK((iMiddle > 2) && (iMiddle < 38));
+	}
+	gbitmap_destroy(bitmap);
+	chart_layer_destroy(layer);
+      }
+    }
+  }
+}
+
+// a history of identical samples is laid out like constant data
+static void test_constant_history(void) {
+  ChartLayer* layer = create_chart(60, 40);
+  CHECK(chart_layer_set_history_capacity(layer, 4));
+  for (int i = 0; i < 30; ++i)
+    CHECK(chart_layer_append_point(layer, i, 5));
+  GContext ctx = { 0 };
+  stub_layer_draw(chart_layer_get_layer(layer), &ctx);
+  ChartLayerData* pData = get_chart_data(layer);
+  CHECK((pData->fYScale > 0) && (pData->fYScale < 1e30f));
+  CHECK(ctx.iNumCalls < 1000);
+  chart_layer_destroy(layer);
+}
+
+// a narrow range far from zero puts the x-axis far outside of the plot,
+// which still only gets the ticks inside of the plot drawn
+static void test_offset_narrow_data(void) {
+  const int aMin[] = { 100000, 101325 };
+  const int aMax[] = { 100010, 101326 };
+  for (unsigned int r = 0; r < sizeof(aMin) / sizeof(aMin[0]); ++r) {
+    int x[16], y[16];
+    unsigned int iNumPoints = 0;
+    for (int v = aMin[r]; v <= aMax[r]; ++v, ++iNumPoints) {
+      x[iNumPoints] = (int)iNumPoints;
+      y[iNumPoints] = v;
+    }
+    ChartLayer* layer = create_chart(144, 168);
+    chart_layer_set_data(layer, x, eINT, y, eINT, iNumPoints);
+    GContext ctx = { 0 };
+    stub_layer_draw(chart_layer_get_layer(layer), &ctx);
+    ChartLayerData* pData = get_chart_data(layer);
+    CHECK((pData->iYAxisIntercept >= -4 * 168) && (pData->iYAxisIntercept <= 4 * 168));
+    CHECK(ctx.iNumCalls < 200);
+    chart_layer_destroy(layer);
+  }
+}
+
+// series data with several points at the same x still gets a finite scale
+static void test_series_duplicate_x(void) {
+  const ChartPlotType aTypes[] = { eSTACKED_BAR, eGROUPED_BAR };
+  const int aX[][4] = { { 3, 3, 3, 3 }, { 1, 1, 4, 4 } };
+  for (unsigned int t = 0; t < sizeof(aTypes) / sizeof(aTypes[0]); ++t) {
+    for (unsigned int d = 0; d < sizeof(aX) / sizeof(aX[0]); ++d) {
+      int y[8] = { 1, 2, -3, 4, 5, 6, 7, -8 };
+      ChartLayer* layer = create_chart(60, 40);
+      chart_layer_set_plot_type(layer, aTypes[t]);
+      chart_layer_set_series_data(layer, aX[d], eINT, y, eINT, 4, 2);
+      GContext ctx = { 0 };
+      stub_layer_draw(chart_layer_get_layer(layer), &ctx);
+      ChartLayerData* pData = get_chart_data(layer);
+      CHECK((pData->fXScale > 0) && (pData->fXScale < 1e30f));
+      CHECK((pData->iBarWidth >= 0) && (pData->iBarWidth <= 60));
+      chart_layer_destroy(layer);
+    }
+  }
+}
+
+///////////////////////////////////
+// histogram
+
+// samples are counted into equal bins over the x-axis range,
+// with the maximum in the last bin and samples outside of the range left out
+static void test_histogram_bins(void) {
+  float aSamples[80];
+  unsigned int iNumSamples = 0;
+  for (int b = 0; b < 10; ++b) {
+    for (int k = 0; k <= b; ++k)
+      aSamples[iNumSamples++] = b + 0.5f;
+  }
+  aSamples[iNumSamples++] = 0;
+  aSamples[iNumSamples++] = 10;
+  aSamples[iNumSamples++] = -1;
+  aSamples[iNumSamples++] = 11;
+  const int aCounts[10] = { 2, 2, 3, 4, 5, 6, 7, 8, 9, 11 };
+
+  ChartLayer* layer = create_chart(60, 40);
+  chart_layer_set_plot_type(layer, eHISTOGRAM);
+  chart_layer_set_histogram_bins(layer, 10);
+  chart_layer_set_xmin(layer, 0);
+  chart_layer_set_xmax(layer, 10);
+  chart_layer_set_samples(layer, aSamples, eFLOAT, iNumSamples);
+  chart_layer_update_layout(layer);
+  ChartLayerData* pData = get_chart_data(layer);
+  const GRect bounds = layer_get_bounds(chart_layer_get_layer(layer));
+  CHECK(pData->iNumPoints == 10);
+  CHECK(pData->fLayoutYMax == 11);
+  for (unsigned int i = 0; i < 10; ++i) {
+    CHECK(pData->pYData[i] == chart_layer_map_y(pData, bounds, aCounts[i]));
+    if (i)
+      CHECK(pData->pXData[i] > pData->pXData[i - 1]);
+  }
+  chart_layer_destroy(layer);
+}
+
+///////////////////////////////////
+// overlays
+
+// the rolling statistics match those computed over each window afresh,
+// and the sum doesn't keep the rounding errors of values long gone
+static void test_rolling_statistics(void) {
+  static float aValues[1000];
+  ChartRolling rolling;
+  CHECK(rolling_init(&rolling, 7));
+  uint32_t iRandom = 1;
+  for (unsigned int i = 0; i < 1000; ++i) {
+    iRandom = (iRandom * 1103515245) + 12345;
+    aValues[i] = (float)((iRandom >> 16) % 2001) - 1000;
+    rolling_push(&rolling, aValues[i]);
+    const unsigned int iFirst = (i < 7) ? 0 : i - 6;
+    float fSum = 0, fMin = aValues[iFirst], fMax = aValues[iFirst];
+    for (unsigned int j = iFirst; j <= i; ++j) {
+      fSum += aValues[j];
+      fMin = (aValues[j] < fMin) ? aValues[j] : fMin;
+      fMax = (aValues[j] > fMax) ? aValues[j] : fMax;
+    }
+    CHECK(rolling_average(&rolling, eSIMPLE_AVERAGE) == fSum / (i - iFirst + 1));
+    CHECK(rolling_min(&rolling) == fMin);
+    CHECK(rolling_max(&rolling) == fMax);
+  }
+
+  // small values after large ones
+  for (unsigned int i = 0; i < 1000; ++i)
+    rolling_push(&rolling, 1e7f + (float)(i % 3) * 0.3f);
+  for (unsigned int i = 0; i < 14; ++i)
+    rolling_push(&rolling, 0.25f);
+  CHECK(rolling_average(&rolling, eSIMPLE_AVERAGE) == 0.25f);
+  rolling_free(&rolling);
+}
+
+// the overlays are the moving average and band of the plotted values,
+// and a window which can't be allocated leaves the chart without them
+static void test_overlays(void) {
+  int x[40], y[40];
+  make_data(x, y, 40);
+  ChartLayer* layer = create_chart(60, 40);
+  ChartLayerData* pData = get_chart_data(layer);
+  GContext ctx = { 0 };
+  chart_layer_set_data(layer, x, eINT, y, eINT, 40);
+  CHECK(chart_layer_set_overlays(layer, eSIMPLE_AVERAGE, true, 5));
+  stub_layer_draw(chart_layer_get_layer(layer), &ctx);
+  CHECK(pData->iNumPoints == 40);
+  CHECK(pData->pAverageData && pData->pBandMinData && pData->pBandMaxData);
+  const GRect bounds = layer_get_bounds(chart_layer_get_layer(layer));
+  for (unsigned int i = 0; (i < 40) && pData->pAverageData; ++i) {
+    const unsigned int iFirst = (i < 5) ? 0 : i - 4;
+    int iSum = 0, iMin = y[iFirst], iMax = y[iFirst];
+    for (unsigned int j = iFirst; j <= i; ++j) {
+      iSum += y[j];
+      iMin = (y[j] < iMin) ? y[j] : iMin;
+      iMax = (y[j] > iMax) ? y[j] : iMax;
+    }
+    CHECK(pData->pAverageData[i] == chart_layer_map_y(pData, bounds, (float)iSum / (i - iFirst + 1)));
+    CHECK(pData->pBandMinData[i] == chart_layer_map_y(pData, bounds, iMin));
+    CHECK(pData->pBandMaxData[i] == chart_layer_map_y(pData, bounds, iMax));
+  }
+
+  stub_set_malloc_limit(1000);
+  CHECK(!chart_layer_set_overlays(layer, eSIMPLE_AVERAGE, true, 1000));
+  stub_set_malloc_limit(SIZE_MAX);
+  stub_layer_draw(chart_layer_get_layer(layer), &ctx);
+  CHECK(!pData->rolling.pValues && !pData->pAverageData && !pData->pBandMinData);
+  CHECK(chart_layer_set_overlays(layer, eNO_AVERAGE, false, 1000));
+  CHECK(!pData->rolling.pValues);
+  CHECK(!chart_layer_set_overlays(NULL, eSIMPLE_AVERAGE, false, 5));
+  chart_layer_destroy(layer);
+}
+
+///////////////////////////////////
+// history store
+
+// true if the history holds the last samples of pX, pY
+static bool history_holds(ChartLayer* layer, const int32_t* pX, const int32_t* pY, const unsigned int iNumSamples) {
+  ChartHistory* pHistory = &get_chart_data(layer)->history;
+  if (pHistory->iNumSamples > iNumSamples)
+    return false;
+  unsigned int i = iNumSamples - pHistory->iNumSamples;
+  for (unsigned int b = 0; b < pHistory->iNumBlocks; ++b) {
+    ChartHistoryCursor cursor;
+    int32_t x, y;
+    history_cursor_init(&cursor, history_get_block(pHistory, b));
+    while (history_cursor_next(&cursor, &x, &y)) {
+      if ((x != pX[i]) || (y != pY[i]))
+	return false;
+      ++i;
+    }
+  }
+  return i == iNumSamples;
+}
+
+// regularly spaced, slowly changing samples take at most a fifth of
+// the memory of the points given to chart_layer_set_data()
+static void test_history_compression(void) {
+  static int32_t x[2000], y[2000];
+  ChartLayer* layer = create_chart(60, 40);
+  CHECK(chart_layer_set_history_capacity(layer, 8));
+  uint32_t iRandom = 1;
+  for (int i = 0; i < 2000; ++i) {
+    iRandom = (iRandom * 1103515245) + 12345;
+    x[i] = i * 60;
+    y[i] = i ? y[i-1] + (int32_t)((iRandom >> 16) % 7) - 3 : 500;
+    CHECK(chart_layer_append_point(layer, x[i], y[i]));
+  }
+  const unsigned int iNumSamples = get_chart_data(layer)->history.iNumSamples;
+  CHECK(iNumSamples >= (5 * 8 * sizeof(ChartHistoryBlock) / (2 * sizeof(int32_t))));
+  CHECK(history_holds(layer, x, y, 2000));
+  chart_layer_destroy(layer);
+}
+
+// irregular samples with large jumps decode to the appended values
+static void test_history_large_deltas(void) {
+  static const int32_t aY[] = { 0, INT32_MAX, INT32_MIN, -1, 1, 7, -8, 8, 127, -128, 32767, -32768, 65536, 0 };
+  const unsigned int iNumSamples = sizeof(aY) / sizeof(aY[0]);
+  int32_t x[sizeof(aY) / sizeof(aY[0])];
+  ChartLayer* layer = create_chart(60, 40);
+  CHECK(chart_layer_set_history_capacity(layer, 4));
+  for (unsigned int i = 0; i < iNumSamples; ++i) {
+    x[i] = (i < 3) ? INT32_MIN + (int32_t)i : (int32_t)(i * i * 1000) - 50000;
+    if (i == (iNumSamples - 1))
+      x[i] = INT32_MAX;
+    CHECK(chart_layer_append_point(layer, x[i], aY[i]));
+  }
+  CHECK(history_holds(layer, x, aY, iNumSamples));
+  chart_layer_destroy(layer);
+}
+
+///////////////////////////////////
+// memory budget
+
+// data over the budget is aggregated into buckets spanning equal x-ranges,
+// so a dense stretch of points doesn't take most of the buckets
+static void test_budget_time_buckets(void) {
+  static int x[1000], y[1000];
+  unsigned int iNumPoints = 0;
+  for (int i = 0; i < 900; ++i, ++iNumPoints) {
+    x[iNumPoints] = i;
+    y[iNumPoints] = i % 10;
+  }
+  for (int i = 900; i <= 9900; i += 100, ++iNumPoints) {
+    x[iNumPoints] = i;
+    y[iNumPoints] = 50;
+  }
+
+  // the budget is a share of the free heap, for 20 buckets
+  stub_set_heap_bytes_free(4000);
+  ChartLayer* layer = create_chart(60, 40);
+  chart_layer_set_memory_budget(layer, 0, 10);
+  chart_layer_set_data(layer, x, eINT, y, eINT, iNumPoints);
+  ChartLayerData* pData = get_chart_data(layer);
+  CHECK(pData->pYMinOrigData && (pData->iBucketCapacity == 20));
+  CHECK((pData->iNumOrigPoints > 5) && (pData->iNumOrigPoints <= 20));
+
+  unsigned int iNumDense = 0;
+  unsigned int iTotal = 0;
+  for (unsigned int i = 0; i < pData->iNumOrigPoints; ++i) {
+    if (pData->pXOrigData[i] < 900)
+      ++iNumDense;
+    iTotal += pData->pBucketCounts[i];
+    CHECK(pData->pYMinOrigData[i] <= pData->pYOrigData[i]);
+    CHECK(pData->pYOrigData[i] <= pData->pYMaxOrigData[i]);
+  }
+  CHECK(iNumDense <= 3);
+  CHECK(iTotal == iNumPoints);
+  CHECK(pData->pYMinOrigData[0] == 0);
+
+  GContext ctx = { 0 };
+  stub_layer_draw(chart_layer_get_layer(layer), &ctx);
+  CHECK(pData->iNumPoints == pData->iNumOrigPoints);
+  chart_layer_destroy(layer);
+  stub_set_heap_bytes_free(64 * 1024);
+}
+
+///////////////////////////////////
+// cursor
+
+// the nearest point to each pixel column is the closest by x-value
+static void test_query_nearest(void) {
+  const int x[] = { 0, 3, 4, 10, 11, 30 };
+  const int y[] = { 5, -2, 8, 1, 0, 12 };
+  const unsigned int iNumPoints = sizeof(x) / sizeof(x[0]);
+  ChartLayer* layer = create_chart(60, 40);
+  chart_layer_set_data(layer, x, eINT, y, eINT, iNumPoints);
+  ChartLayerData* pData = get_chart_data(layer);
+  for (int px = 0; px < 60; ++px) {
+    float fX = -1, fY = -1;
+    CHECK(chart_layer_query_nearest(layer, px, &fX, &fY));
+    const float fColumnX = ((px - pData->iMargin) / pData->fXScale) + pData->fLayoutXMin - (pData->fLayoutXSep / 2);
+    float fDistance = 1e30f;
+    for (unsigned int i = 0; i < iNumPoints; ++i) {
+      const float d = (x[i] < fColumnX) ? fColumnX - x[i] : x[i] - fColumnX;
+      if (d < fDistance)
+	fDistance = d;
+    }
+    const float d = (fX < fColumnX) ? fColumnX - fX : fX - fColumnX;
+    CHECK(d == fDistance);
+    for (unsigned int i = 0; i < iNumPoints; ++i) {
+      if (x[i] == fX)
+	CHECK(y[i] == fY);
+    }
+  }
+  CHECK(!chart_layer_query_nearest(layer, 0, NULL, NULL));
+  chart_layer_destroy(layer);
+}
+
+// the cursor is drawn by its own layer, leaving the layout of the chart in place,
+// and isn't drawn for histograms
+static void test_cursor(void) {
+  int x[20], y[20];
+  make_data(x, y, 20);
+  ChartLayer* layer = create_chart(60, 40);
+  chart_layer_set_data(layer, x, eINT, y, eINT, 20);
+  ChartLayerData* pData = get_chart_data(layer);
+  chart_layer_update_layout(layer);
+  const unsigned int iChartDirty = stub_layer_dirty_count(chart_layer_get_layer(layer));
+
+  chart_layer_set_cursor(layer, x[7]);
+  CHECK(pData->pCursorLayer && (pData->fCursorX == x[7]));
+  CHECK(stub_layer_dirty_count(pData->pCursorLayer) == 1);
+  chart_layer_set_cursor(layer, x[8]);
+  CHECK(stub_layer_dirty_count(pData->pCursorLayer) == 2);
+  CHECK(stub_layer_dirty_count(chart_layer_get_layer(layer)) == iChartDirty);
+  CHECK(!pData->bLayoutDirty);
+
+  GContext ctx = { 0 };
+  stub_layer_draw(pData->pCursorLayer, &ctx);
+  CHECK(ctx.iNumCalls > 0);
+
+  chart_layer_clear_cursor(layer);
+  CHECK(pData->fCursorX == NOT_SET);
+  ctx.iNumCalls = 0;
+  stub_layer_draw(pData->pCursorLayer, &ctx);
+  CHECK(ctx.iNumCalls == 0);
+
+  chart_layer_set_plot_type(layer, eHISTOGRAM);
+  chart_layer_set_cursor(layer, x[7]);
+  float fX, fY;
+  CHECK(!chart_layer_query_nearest(layer, 30, &fX, &fY));
+  stub_layer_draw(pData->pCursorLayer, &ctx);
+  CHECK(ctx.iNumCalls == 0);
+  chart_layer_destroy(layer);
+}
+
+///////////////////////////////////
+// persistence
+
+// true if both charts render to the same pixels
+static bool render_equal(ChartLayer* layer1, ChartLayer* layer2) {
+  GBitmap* bitmap1 = gbitmap_create_blank((GSize) { 60, 40 }, GBitmapFormat1Bit);
+  GBitmap* bitmap2 = gbitmap_create_blank((GSize) { 60, 40 }, GBitmapFormat1Bit);
+  const bool bEqual = chart_layer_render_to_bitmap(layer1, bitmap1) && chart_layer_render_to_bitmap(layer2, bitmap2) &&
+    !memcmp(gbitmap_get_data(bitmap1), gbitmap_get_data(bitmap2), 40 * gbitmap_get_bytes_per_row(bitmap1));
+  gbitmap_destroy(bitmap1);
+  gbitmap_destroy(bitmap2);
+  return bEqual;
+}
+
+// a restored layout maps pixels to values like the layout it was saved from
+static void test_restore_query_nearest(void) {
+  int x[20], y[20];
+  make_data(x, y, 20);
+  stub_persist_clear();
+  ChartLayer* saved = create_chart(60, 40);
+  chart_layer_set_data(saved, x, eINT, y, eINT, 20);
+  CHECK(chart_layer_persist_layout(saved, 100, 1));
+
+  ChartLayer* restored = create_chart(60, 40);
+  chart_layer_set_data(restored, x, eINT, y, eINT, 20);
+  CHECK(chart_layer_restore_layout(restored, 100, 1));
+  CHECK(!get_chart_data(restored)->bLayoutDirty);
+  for (int px = 0; px < 60; px += 7) {
+    float fSavedX = 0, fSavedY = 0, fRestoredX = 1, fRestoredY = 1;
+    CHECK(chart_layer_query_nearest(saved, px, &fSavedX, &fSavedY));
+    CHECK(chart_layer_query_nearest(restored, px, &fRestoredX, &fRestoredY));
+    CHECK((fSavedX == fRestoredX) && (fSavedY == fRestoredY));
+  }
+  CHECK(render_equal(saved, restored));
+  chart_layer_destroy(saved);
+  chart_layer_destroy(restored);
+}
+
+// a layout isn't restored into a chart configured differently,
+// nor saved or restored with overlays, which it doesn't hold
+static void test_restore_key(void) {
+  int x[20], y[20];
+  make_data(x, y, 20);
+  stub_persist_clear();
+  ChartLayer* saved = create_chart(60, 40);
+  chart_layer_set_data(saved, x, eINT, y, eINT, 20);
+  CHECK(chart_layer_persist_layout(saved, 100, 1));
+
+  for (int iChange = 0; iChange < 5; ++iChange) {
+    ChartLayer* restored = create_chart(60, 40);
+    switch (iChange) {
+    case 0: chart_layer_set_histogram_bins(restored, 5); break;
+    case 1: chart_layer_set_autoscale(restored, true, 0.1); break;
+    case 2: chart_layer_show_frame(restored, true); break;
+    case 3: chart_layer_set_overlays(restored, eSIMPLE_AVERAGE, false, 0); break;
+    case 4: chart_layer_set_overlays(restored, eSIMPLE_AVERAGE, true, 4); break;
+    }
+    chart_layer_set_data(restored, x, eINT, y, eINT, 20);
+    CHECK(!chart_layer_restore_layout(restored, 100, 1));
+    CHECK(get_chart_data(restored)->bLayoutDirty);
+    chart_layer_destroy(restored);
+  }
+
+  chart_layer_set_overlays(saved, eSIMPLE_AVERAGE, true, 4);
+  CHECK(!chart_layer_persist_layout(saved, 200, 1));
+  CHECK(get_chart_data(saved)->pAverageData && get_chart_data(saved)->pBandMinData);
+  chart_layer_destroy(saved);
+}
+
+// appending to a restored history layout uses the saved scale
+static void test_restore_history_append(void) {
+  stub_persist_clear();
+  ChartLayer* saved = create_chart(60, 40);
+  ChartLayer* restored = create_chart(60, 40);
+  CHECK(chart_layer_set_history_capacity(saved, 4));
+  CHECK(chart_layer_set_history_capacity(restored, 4));
+  for (int i = 0; i < 20; ++i) {
+    CHECK(chart_layer_append_point(saved, i, (i * 7) % 10));
+    CHECK(chart_layer_append_point(restored, i, (i * 7) % 10));
+  }
+  CHECK(chart_layer_persist_layout(saved, 100, 1));
+  CHECK(chart_layer_restore_layout(restored, 100, 1));
+  CHECK(get_chart_data(restored)->fXScale == get_chart_data(saved)->fXScale);
+  CHECK(get_chart_data(restored)->fYScale == get_chart_data(saved)->fYScale);
+
+  CHECK(chart_layer_append_point(saved, 20, 5));
+  CHECK(chart_layer_append_point(restored, 20, 5));
+  CHECK(render_equal(saved, restored));
+  chart_layer_destroy(saved);
+  chart_layer_destroy(restored);
+}
+
+///////////////////////////////////
+// morphing
+
+// a completely drawn chart moves its points from the previous line to the
+// new layout, instead of drawing the new chart from scratch
+static void test_morph(void) {
+  int x[40], y[40], yNew[40], aOld[40];
+  make_data(x, y, 40);
+  for (unsigned int i = 0; i < 40; ++i)
+    yNew[i] = 20 - y[i];
+  ChartLayer* target = create_chart(60, 40);
+  chart_layer_set_data(target, x, eINT, yNew, eINT, 40);
+  GContext ctx = { 0 };
+  stub_layer_draw(chart_layer_get_layer(target), &ctx);
+  const int* pTargetY = get_chart_data(target)->pYData;
+
+  ChartLayer* layer = create_chart(60, 40);
+  ChartLayerData* pData = get_chart_data(layer);
+  chart_layer_animate(layer, true);
+  chart_layer_set_morph(layer, true);
+  chart_layer_set_data(layer, x, eINT, y, eINT, 40);
+  stub_layer_draw(chart_layer_get_layer(layer), &ctx);
+  CHECK(!pData->pMorphData && (pData->iPointsToDraw < pData->iNumPoints));
+  stub_animation_finish(pData->pAnimation);
+  CHECK(pData->iPointsToDraw == pData->iNumPoints);
+  memcpy(aOld, pData->pYData, sizeof(aOld));
+
+  // all the points are drawn from the start, at their old positions
+  chart_layer_set_data(layer, x, eINT, yNew, eINT, 40);
+  stub_layer_draw(chart_layer_get_layer(layer), &ctx);
+  CHECK(pData->pMorphData && chart_layer_is_animating(pData));
+  CHECK(pData->iPointsToDraw == pData->iNumPoints);
+  CHECK(!memcmp(pData->pYData, aOld, sizeof(aOld)));
+
+  // and move over the animation
+  animation_update(pData->pAnimation, ANIMATION_NORMALIZED_MAX / 2);
+  for (unsigned int i = 0; i < 40; ++i) {
+    const int iTwice = 2 * pData->pYData[i];
+    CHECK((iTwice >= aOld[i] + pTargetY[i] - 1) && (iTwice <= aOld[i] + pTargetY[i] + 1));
+  }
+  stub_animation_finish(pData->pAnimation);
+  CHECK(!pData->pMorphData && !chart_layer_is_animating(pData));
+  CHECK(!memcmp(pData->pYData, pTargetY, sizeof(aOld)));
+
+  // a different number of points starts from the old line
+  memcpy(aOld, pData->pYData, sizeof(aOld));
+  chart_layer_set_data(layer, x, eINT, y, eINT, 25);
+  stub_layer_draw(chart_layer_get_layer(layer), &ctx);
+  CHECK(pData->pMorphData && (pData->iNumPoints == 25));
+  int iOldMin = aOld[0], iOldMax = aOld[0];
+  for (unsigned int i = 1; i < 40; ++i) {
+    iOldMin = (aOld[i] < iOldMin) ? aOld[i] : iOldMin;
+    iOldMax = (aOld[i] > iOldMax) ? aOld[i] : iOldMax;
+  }
+  for (unsigned int i = 0; i < 25; ++i)
+    CHECK((pData->pYData[i] >= iOldMin) && (pData->pYData[i] <= iOldMax));
+  stub_animation_finish(pData->pAnimation);
+
+  // without morphing, new data is drawn from scratch
+  chart_layer_set_morph(layer, false);
+  chart_layer_set_data(layer, x, eINT, yNew, eINT, 40);
+  stub_layer_draw(chart_layer_get_layer(layer), &ctx);
+  CHECK(!pData->pMorphData && (pData->iPointsToDraw < pData->iNumPoints));
+  chart_layer_destroy(layer);
+  chart_layer_destroy(target);
+}
+
+///////////////////////////////////
+// shared animator
+
+// charts registered with an animator are advanced by the time since each
+// started, from a single animation which redraws only the root layer
+static void test_animator(void) {
+  int x[40], y[40];
+  make_data(x, y, 40);
+  const int iNumAnimations = stub_animation_count();
+  Layer* root = layer_create((GRect) { .origin = { 0, 0 }, .size = { 144, 168 } });
+  ChartAnimator* animator = chart_animator_create(root);
+  CHECK(animator && (stub_animation_count() == iNumAnimations + 1));
+
+  ChartLayer* aCharts[2];
+  const uint32_t aDurations[2] = { 1000, 500 };
+  GContext ctx = { 0 };
+  stub_set_time_ms(10000);
+  for (unsigned int c = 0; c < 2; ++c) {
+    aCharts[c] = create_chart(60, 40);
+    chart_layer_animate(aCharts[c], true);
+    chart_layer_set_animation_duration(aCharts[c], aDurations[c]);
+    chart_layer_set_animator(aCharts[c], animator);
+    chart_layer_set_data(aCharts[c], x, eINT, y, eINT, 40);
+    stub_layer_draw(chart_layer_get_layer(aCharts[c]), &ctx);
+  }
+  ChartLayerData* pSlow = get_chart_data(aCharts[0]);
+  ChartLayerData* pFast = get_chart_data(aCharts[1]);
+  CHECK(pSlow->bAnimating && pFast->bAnimating);
+  CHECK(!pSlow->pAnimation && !pFast->pAnimation);
+  CHECK(stub_animation_count() == iNumAnimations + 1);
+  CHECK(animation_is_scheduled(animator->pAnimation));
+
+  const unsigned int iRootDirty = stub_layer_dirty_count(root);
+  const unsigned int iSlowDirty = stub_layer_dirty_count(chart_layer_get_layer(aCharts[0]));
+  stub_set_time_ms(10250);
+  chart_animator_update(animator->pAnimation, ANIMATION_NORMALIZED_MAX / 4);
+  CHECK((pSlow->iPointsToDraw >= 9) && (pSlow->iPointsToDraw <= 10));
+  CHECK((pFast->iPointsToDraw >= 19) && (pFast->iPointsToDraw <= 20));
+  CHECK(stub_layer_dirty_count(root) == iRootDirty + 1);
+  CHECK(stub_layer_dirty_count(chart_layer_get_layer(aCharts[0])) == iSlowDirty);
+
+  stub_set_time_ms(10600);
+  chart_animator_update(animator->pAnimation, ANIMATION_NORMALIZED_MAX / 2);
+  CHECK(!pFast->bAnimating && (pFast->iPointsToDraw == 40));
+  CHECK(pSlow->bAnimating && (pSlow->iPointsToDraw >= 23) && (pSlow->iPointsToDraw <= 24));
+  stub_animation_finish(animator->pAnimation);
+  CHECK(!pSlow->bAnimating && (pSlow->iPointsToDraw == 40));
+
+  // charts go back to animating themselves, starting over
+  stub_set_time_ms(20000);
+  chart_layer_set_data(aCharts[0], x, eINT, y, eINT, 30);
+  stub_layer_draw(chart_layer_get_layer(aCharts[0]), &ctx);
+  CHECK(pSlow->bAnimating);
+  chart_animator_destroy(animator);
+  CHECK(stub_animation_count() == iNumAnimations);
+  CHECK(!pSlow->pAnimator && !pFast->pAnimator && !pSlow->bAnimating);
+  for (unsigned int c = 0; c < 2; ++c)
+    stub_layer_draw(chart_layer_get_layer(aCharts[c]), &ctx);
+  CHECK(pSlow->pAnimation && animation_is_scheduled(pSlow->pAnimation));
+  CHECK(!pFast->pAnimation);
+  CHECK(stub_animation_count() == iNumAnimations + 1);
+
+  for (unsigned int c = 0; c < 2; ++c)
+    chart_layer_destroy(aCharts[c]);
+  layer_destroy(root);
+  CHECK(stub_animation_count() == iNumAnimations);
+  stub_set_time_ms(0);
+}
+
+///////////////////////////////////
+// sparkline
+
+// values are sampled down to the kept points, including the first and the
+// last, and the last is drawn at the right edge, within the range if set
+static void test_sparkline(void) {
+  int y[200];
+  for (unsigned int i = 0; i < 200; ++i)
+    y[i] = (int)((i * 37) % 101);
+  y[0] = -100;
+  y[199] = 200;
+  SparklineLayer* sparkline = sparkline_layer_create((GRect) { .origin = { 0, 0 }, .size = { 30, 11 } });
+  Layer* layer = sparkline_layer_get_layer(sparkline);
+  SparklineLayerData* pData = get_sparkline_data(sparkline);
+  const unsigned int iDirty = stub_layer_dirty_count(layer);
+  sparkline_layer_set_data(sparkline, y, eINT, 200);
+  CHECK(stub_layer_dirty_count(layer) == iDirty + 1);
+  CHECK(pData->iNumPoints == SPARKLINE_MAX_POINTS);
+  CHECK((pData->fDataMin == -100) && (pData->fDataMax == 200));
+  CHECK((pData->aYData[0] == 0) && (pData->aYData[SPARKLINE_MAX_POINTS - 1] == SPARKLINE_LEVELS));
+
+  GContext ctx = { 0 };
+  stub_layer_draw(layer, &ctx);
+  CHECK(ctx.iNumCalls == SPARKLINE_MAX_POINTS - 1);
+  CHECK((ctx.lastPoint.x == 29) && (ctx.lastPoint.y == 0));
+
+  // the range is spanned by the height, and values above it are drawn at the top
+  sparkline_layer_set_range(sparkline, -100, 400);
+  ctx = (GContext) { 0 };
+  stub_layer_draw(layer, &ctx);
+  CHECK((ctx.lastPoint.x == 29) && (ctx.lastPoint.y == 4));
+  sparkline_layer_set_range(sparkline, -100, 100);
+  stub_layer_draw(layer, &ctx);
+  CHECK(ctx.lastPoint.y == 0);
+  sparkline_layer_clear_range(sparkline);
+  CHECK(stub_layer_dirty_count(layer) == iDirty + 4);
+
+  // a single value is a pixel, constant values are in the middle
+  sparkline_layer_set_data(sparkline, y, eINT, 1);
+  ctx = (GContext) { 0 };
+  stub_layer_draw(layer, &ctx);
+  CHECK((ctx.iNumCalls == 1) && (ctx.lastPoint.x == 29) && (ctx.lastPoint.y == 5));
+  sparkline_layer_set_data(sparkline, y, eINT, 0);
+  ctx = (GContext) { 0 };
+  stub_layer_draw(layer, &ctx);
+  CHECK(!ctx.iNumCalls);
+  sparkline_layer_destroy(sparkline);
+}
+
+///////////////////////////////////
+// timing
+
+// microseconds per call of fn over iRuns runs
+static double time_runs(void (*fn)(ChartLayer*, GBitmap*, const int*, const int*, unsigned int),
+			ChartLayer* layer, GBitmap* bitmap, const int* pX, const int* pY,
+			const unsigned int iNumPoints, const unsigned int iRuns) {
+  const clock_t start = clock();
+  for (unsigned int i = 0; i < iRuns; ++i)
+    fn(layer, bitmap, pX, pY, iNumPoints);
+  return 1e6 * (double)(clock() - start) / CLOCKS_PER_SEC / iRuns;
+}
+
+static void run_set_data_and_render(ChartLayer* layer, GBitmap* bitmap, const int* pX, const int* pY, unsigned int iNumPoints) {
+  chart_layer_set_data(layer, pX, eINT, pY, eINT, iNumPoints);
+  chart_layer_render_to_bitmap(layer, bitmap);
+}
+
+static void run_render(ChartLayer* layer, GBitmap* bitmap, const int* pX, const int* pY, unsigned int iNumPoints) {
+  chart_layer_render_to_bitmap(layer, bitmap);
+}
+
+static void bench(void) {
+  static int x[5000], y[5000];
+  make_data(x, y, 5000);
+  const struct {
+    const char* pName;
+    ChartPlotType type;
+    unsigned int iNumPoints;
+  } aCases[] = {
+    { "line", eLINE, 100 },
+    { "line", eLINE, 5000 },
+    { "scatter", eSCATTER, 1000 },
+    { "bar", eBAR, 50 },
+  };
+
+  // a full screen chart on a 1-bit display
+  GBitmap* bitmap = gbitmap_create_blank((GSize) { 144, 168 }, GBitmapFormat1Bit);
+  printf("%-8s %6s %16s %12s\n", "type", "points", "layout+draw us", "draw us");
+  for (unsigned int i = 0; i < sizeof(aCases) / sizeof(aCases[0]); ++i) {
+    ChartLayer* layer = create_chart(144, 168);
+    chart_layer_set_plot_type(layer, aCases[i].type);
+    const double fFull = time_runs(run_set_data_and_render, layer, bitmap, x, y, aCases[i].iNumPoints, 200);
+    const double fDraw = time_runs(run_render, layer, bitmap, x, y, aCases[i].iNumPoints, 200);
+    printf("%-8s %6u %16.1f %12.1f\n", aCases[i].pName, aCases[i].iNumPoints, fFull, fDraw);
+    chart_layer_destroy(layer);
+  }
+  gbitmap_destroy(bitmap);
+}
+
+int main(int argc, char** argv) {
+  for (int i = 1; i < argc; ++i) {
+    if (!strcmp(argv[i], "--update-golden"))
+      s_bUpdateGolden = true;
+    else if (!strcmp(argv[i], "--bench")) {
+      bench();
+      return 0;
+    }
+    else {
+      printf("usage: %s [--update-golden | --bench]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  test_render_line();
+  test_render_bar();
+  test_render_scatter();
+  test_render_8bit();
+  test_render_clipped();
+  test_render_finishes_animation();
+  test_render_unsupported();
+  test_create_initializes_layout();
+  test_append_without_sampling();
+  test_ingest_packed();
+  test_ingest_packed_malformed();
+  test_ingest_packed_overflow();
+  test_autoscale_kept_across_data();
+  test_autoscale_fitting_data();
+  test_autoscale_new_range_is_kept();
+  test_constant_data();
+  test_constant_history();
+  test_offset_narrow_data();
+  test_series_duplicate_x();
+  test_histogram_bins();
+  test_rolling_statistics();
+  test_overlays();
+  test_history_compression();
+  test_history_large_deltas();
+  test_budget_time_buckets();
+  test_query_nearest();
+  test_cursor();
+  test_restore_query_nearest();
+  test_restore_key();
+  test_restore_history_append();
+  test_morph();
+  test_animator();
+  test_sparkline();
+
+  printf("%d checks, %d failed\n", s_iNumChecks, s_iNumFailed);
+  return s_iNumFailed ? 1 : 0;
+}